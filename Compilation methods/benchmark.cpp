@@ -0,0 +1,484 @@
+#include "benchmark.h"
+#include "lexer.h"
+#include "parser.h"
+#include "optimizer.h"
+#include "interpreter.h"
+#include "compilation_cache.h"
+#include "bytecode.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const int BENCH_REPEATS = 3;
+
+std::string generate_declarations_program(size_t count) {
+    std::ostringstream code;
+    code << "int v0 = 1;\n";
+    size_t last = 0;
+    for (size_t k = 1; k < count; ++k) {
+        if (k % 16 == 0) {
+            code << "int a" << k << "[8];\n";
+        }
+        else {
+            code << "int v" << k << " = v" << last << " + " << (k % 10) << ";\n";
+            last = k;
+        }
+    }
+    code << "print(v" << last << ");\n";
+    return code.str();
+}
+
+std::string generate_nested_program(size_t depth) {
+    std::ostringstream code;
+    for (size_t k = 0; k < depth; ++k) {
+        code << "int d" << k << ";\n";
+    }
+    code << "int acc = 0;\nint r = 0;\nwhile (r < 100) {\n";
+    // Каждый уровень — цикл из одной итерации с ветвлением внутри.
+    for (size_t k = 0; k < depth; ++k) {
+        std::string pad(4 + k * 8, ' ');
+        code << pad << "d" << k << " = 1;\n";
+        code << pad << "while (d" << k << " > 0) {\n";
+        code << pad << "    d" << k << " = d" << k << " - 1;\n";
+        code << pad << "    acc = acc + " << (k % 3) << ";\n";
+        code << pad << "    if (acc < 1000000000) {\n";
+    }
+    code << std::string(4 + depth * 8, ' ') << "acc = acc + 1;\n";
+    for (size_t k = depth; k-- > 0;) {
+        std::string pad(4 + k * 8, ' ');
+        code << pad << "    } else {\n";
+        code << pad << "        acc = 0;\n";
+        code << pad << "    }\n";
+        code << pad << "}\n";
+    }
+    code << "    r = r + 1;\n}\nprint(acc);\n";
+    return code.str();
+}
+
+std::string generate_expression_program(size_t terms) {
+    std::ostringstream code;
+    code << "int x = 3;\nint y = 5;\nint k = 0;\nint s = 0;\nwhile (k < 100) {\n    s = x";
+    for (size_t t = 1; t < terms; ++t) {
+        code << (t % 2 ? " + " : " - ");
+        switch (t % 5) {
+        case 0: code << "x"; break;
+        case 1: code << "(y * 2 - x)"; break;
+        case 2: code << (t % 97); break;
+        case 3: code << "(x + y) * " << (t % 7); break;
+        default: code << "y / " << (t % 4 + 1); break;
+        }
+    }
+    code << ";\n    k = k + 1;\n}\nprint(s);\n";
+    return code.str();
+}
+
+std::string generate_sort_program() {
+    return
+        "int n;\n"
+        "read(n);\n"
+        "int arr[n];\n"
+        "int i = 0;\n"
+        "while (i < n) {\n"
+        "    read(arr[i]);\n"
+        "    i = i + 1;\n"
+        "}\n"
+        "i = 0;\n"
+        "int j = 0;\n"
+        "int temp;\n"
+        "while (i < n - 1) {\n"
+        "    j = 0;\n"
+        "    while (j < n - i - 1) {\n"
+        "        if (arr[j] > arr[j + 1]) {\n"
+        "            temp = arr[j];\n"
+        "            arr[j] = arr[j + 1];\n"
+        "            arr[j + 1] = temp;\n"
+        "        }\n"
+        "        j = j + 1;\n"
+        "    }\n"
+        "    i = i + 1;\n"
+        "}\n"
+        "print(arr[0]);\n"
+        "print(arr[n - 1]);\n";
+}
+
+std::string generate_sort_input(size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> value(0, 99999);
+    std::ostringstream input;
+    input << count << "\n";
+    for (size_t k = 0; k < count; ++k) {
+        input << value(rng) << (k + 1 < count ? " " : "\n");
+    }
+    return input.str();
+}
+
+struct BenchmarkCase {
+    std::string workload;
+    size_t size;
+    std::string source_file;
+    std::string input_file;
+};
+
+struct BenchmarkResult {
+    size_t source_bytes = 0;
+    size_t tokens = 0;
+    size_t ops = 0;
+    size_t executed = 0;
+    double lex_seconds = 0;
+    double parse_seconds = 0;
+    double optimize_seconds = 0;
+    double execute_seconds = 0;
+};
+
+static std::string read_text(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file " + path);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+static void write_text(const std::string& path, const std::string& text) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file " + path + " for writing");
+    }
+    file << text;
+}
+
+// Каждая фаза замеряется BENCH_REPEATS раз, берётся лучшее время.
+static BenchmarkResult measure(const BenchmarkCase& bench) {
+    using clock = std::chrono::steady_clock;
+    auto seconds_since = [](clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    };
+
+    std::string code = read_text(bench.source_file);
+    std::string input = bench.input_file.empty() ? "" : read_text(bench.input_file);
+    std::ostream discard(nullptr);
+
+    BenchmarkResult result;
+    result.source_bytes = code.size();
+    for (int repeat = 0; repeat < BENCH_REPEATS; ++repeat) {
+        auto start = clock::now();
+        Lexer lexer(code);
+        std::vector<Token> tokens = lexer.tokenize();
+        SourceLines lines(code);
+        double lex_seconds = seconds_since(start);
+
+        SymbolTable sym_table;
+        sym_table.set_silent_mode(true);
+        Parser parser(sym_table);
+        parser.set_silent_mode(true);
+        start = clock::now();
+        std::vector<OPS> ops = parser.parse(tokens, lines);
+        double parse_seconds = seconds_since(start);
+
+        Optimizer optimizer;
+        optimizer.set_silent_mode(true);
+        start = clock::now();
+        ops = optimizer.optimize(ops);
+        double optimize_seconds = seconds_since(start);
+
+        std::istringstream in(input);
+        Interpreter interpreter(sym_table);
+        interpreter.set_silent_mode(true);
+        interpreter.set_io_streams(in, discard);
+        start = clock::now();
+        interpreter.execute(ops);
+        double execute_seconds = seconds_since(start);
+
+        if (repeat == 0 || lex_seconds < result.lex_seconds) result.lex_seconds = lex_seconds;
+        if (repeat == 0 || parse_seconds < result.parse_seconds) result.parse_seconds = parse_seconds;
+        if (repeat == 0 || optimize_seconds < result.optimize_seconds) result.optimize_seconds = optimize_seconds;
+        if (repeat == 0 || execute_seconds < result.execute_seconds) result.execute_seconds = execute_seconds;
+        result.tokens = tokens.size();
+        result.ops = ops.size();
+        result.executed = interpreter.get_executed_count();
+    }
+    return result;
+}
+
+static double per_second(double amount, double seconds) {
+    return seconds > 0 ? amount / seconds : 0.0;
+}
+
+int run_benchmarks(const std::string& directory) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    auto path = [&](const std::string& name) {
+        return (std::filesystem::path(directory) / name).string();
+    };
+
+    std::vector<BenchmarkCase> cases;
+    try {
+        for (size_t n : { 1000, 10000, 50000 }) {
+            cases.push_back({ "declarations", n, path("bench_decl_" + std::to_string(n) + ".txt"), "" });
+            write_text(cases.back().source_file, generate_declarations_program(n));
+        }
+        for (size_t n : { 16, 64, 256 }) {
+            cases.push_back({ "nested", n, path("bench_nested_" + std::to_string(n) + ".txt"), "" });
+            write_text(cases.back().source_file, generate_nested_program(n));
+        }
+        for (size_t n : { 100, 1000, 10000 }) {
+            cases.push_back({ "expression", n, path("bench_expr_" + std::to_string(n) + ".txt"), "" });
+            write_text(cases.back().source_file, generate_expression_program(n));
+        }
+        write_text(path("bench_sort.txt"), generate_sort_program());
+        for (size_t n : { 100, 300, 1000 }) {
+            cases.push_back({ "bubble_sort", n, path("bench_sort.txt"), path("bench_sort_" + std::to_string(n) + ".in") });
+            write_text(cases.back().input_file, generate_sort_input(n, static_cast<unsigned>(n)));
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::string results_file = path("results.csv");
+    std::ofstream csv(results_file, std::ios::trunc);
+    if (!csv.is_open()) {
+        std::cerr << "Error: Cannot open file " << results_file << " for writing" << std::endl;
+        return 1;
+    }
+    csv << "compiler_version,workload,size,source_bytes,tokens,ops,executed,"
+        "lex_s,parse_s,optimize_s,execute_s,lex_mb_per_s,parse_tokens_per_s,execute_ops_per_s\n";
+
+    std::cout << std::left << std::setw(14) << "workload" << std::right << std::setw(8) << "size"
+        << std::setw(12) << "lex MB/s" << std::setw(14) << "tokens/s" << std::setw(12) << "opt ms" << std::setw(14) << "ops/s" << "\n";
+    int failed = 0;
+    for (const auto& bench : cases) {
+        BenchmarkResult r;
+        try {
+            r = measure(bench);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error in " << bench.source_file << ": " << e.what() << "\n";
+            ++failed;
+            continue;
+        }
+        double lex_mb = per_second(r.source_bytes / 1e6, r.lex_seconds);
+        double tokens_rate = per_second(static_cast<double>(r.tokens), r.parse_seconds);
+        double ops_rate = per_second(static_cast<double>(r.executed), r.execute_seconds);
+        csv << COMPILER_VERSION << "," << bench.workload << "," << bench.size << "," << r.source_bytes << "," << r.tokens << ","
+            << r.ops << "," << r.executed << "," << r.lex_seconds << "," << r.parse_seconds << "," << r.optimize_seconds << ","
+            << r.execute_seconds << "," << lex_mb << "," << tokens_rate << "," << ops_rate << "\n";
+        std::cout << std::left << std::setw(14) << bench.workload << std::right << std::setw(8) << bench.size
+            << std::fixed << std::setprecision(2) << std::setw(12) << lex_mb
+            << std::setprecision(0) << std::setw(14) << tokens_rate
+            << std::setprecision(2) << std::setw(12) << r.optimize_seconds * 1000
+            << std::setprecision(0) << std::setw(14) << ops_rate << "\n";
+        std::cout.unsetf(std::ios::fixed);
+    }
+    std::cout << "=== Benchmark results written to " << results_file << " ===\n";
+    return failed == 0 ? 0 : 1;
+}
+
+// Счётчики инструкций и тактов процессора; без perf_event_open (не Linux, запрет в
+// perf_event_paranoid, контейнер) available() возвращает false.
+class PerfCounters {
+public:
+    PerfCounters() : cycles_fd(-1), instructions_fd(-1) {
+#ifdef __linux__
+        cycles_fd = open_counter(PERF_COUNT_HW_CPU_CYCLES, -1);
+        if (cycles_fd >= 0) instructions_fd = open_counter(PERF_COUNT_HW_INSTRUCTIONS, cycles_fd);
+#endif
+    }
+    ~PerfCounters() {
+#ifdef __linux__
+        if (instructions_fd >= 0) close(instructions_fd);
+        if (cycles_fd >= 0) close(cycles_fd);
+#endif
+    }
+    bool available() const {
+        return cycles_fd >= 0 && instructions_fd >= 0;
+    }
+    void start() {
+#ifdef __linux__
+        if (!available()) return;
+        ioctl(cycles_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(cycles_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+    // Возвращает отношение инструкций к тактам с момента start().
+    double stop() {
+#ifdef __linux__
+        if (!available()) return 0.0;
+        ioctl(cycles_fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        uint64_t cycles = 0, instructions = 0;
+        if (read(cycles_fd, &cycles, sizeof(cycles)) != sizeof(cycles)) return 0.0;
+        if (read(instructions_fd, &instructions, sizeof(instructions)) != sizeof(instructions)) return 0.0;
+        return cycles ? static_cast<double>(instructions) / static_cast<double>(cycles) : 0.0;
+#else
+        return 0.0;
+#endif
+    }
+
+private:
+#ifdef __linux__
+    static int open_counter(uint64_t config, int group_fd) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.disabled = group_fd < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0));
+    }
+#endif
+    int cycles_fd;
+    int instructions_fd;
+};
+
+struct Microbenchmark {
+    std::string name;
+    std::string unit;         // что повторяется (для отчёта)
+    std::vector<OPS> prologue; // выполняется один раз на итерацию до развёрнутых повторений
+    std::vector<OPS> body;     // повторяемый фрагмент; переходы заданы относительно его начала
+    std::vector<OPS> epilogue;
+};
+
+static const size_t MICRO_UNROLL = 256;
+static const int MICRO_ITERATIONS = 4000;
+
+// Цикл по i из MICRO_ITERATIONS итераций, в теле — пролог, MICRO_UNROLL копий фрагмента и эпилог.
+static std::vector<OPS> build_micro_program(const Microbenchmark& bench, size_t unroll) {
+    std::vector<OPS> ops = {
+        { "", "16" }, { "alloc_array", "a" },
+        { "", "0" }, { "=", "i" },
+    };
+    size_t head = ops.size();
+    ops.insert(ops.end(), { { "", "i" }, { "", std::to_string(MICRO_ITERATIONS) }, { "<" }, { "jf", "" } });
+    size_t exit_jump = ops.size() - 1;
+    ops.insert(ops.end(), bench.prologue.begin(), bench.prologue.end());
+    for (size_t u = 0; u < unroll; ++u) {
+        size_t base = ops.size();
+        for (OPS op : bench.body) {
+            if (is_jump_operation(op.operation)) op.operand = std::to_string(base + std::stoul(op.operand));
+            ops.push_back(op);
+        }
+    }
+    ops.insert(ops.end(), bench.epilogue.begin(), bench.epilogue.end());
+    ops.insert(ops.end(), { { "", "i" }, { "", "1" }, { "+" }, { "=", "i" }, { "j", std::to_string(head) } });
+    ops[exit_jump].operand = std::to_string(ops.size());
+    return ops;
+}
+
+struct MicroResult {
+    double seconds = 0;
+    size_t executed = 0;
+    double ipc = 0;
+};
+
+static MicroResult run_micro_program(const std::vector<OPS>& ops, PerfCounters& counters) {
+    std::ostream discard(nullptr);
+    std::istringstream no_input;
+    MicroResult best;
+    for (int repeat = 0; repeat < BENCH_REPEATS; ++repeat) {
+        SymbolTable sym_table;
+        sym_table.set_silent_mode(true);
+        for (const char* name : { "i", "x", "y", "acc" }) {
+            sym_table.add_variable(name, 1);
+        }
+        BytecodeImage image = compile_bytecode(ops, sym_table);
+        Interpreter interpreter(sym_table);
+        interpreter.set_silent_mode(true);
+        interpreter.set_io_streams(no_input, discard);
+
+        auto start = std::chrono::steady_clock::now();
+        counters.start();
+        interpreter.execute(image);
+        double ipc = counters.stop();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (repeat == 0 || seconds < best.seconds) {
+            best.seconds = seconds;
+            best.ipc = ipc;
+        }
+        best.executed = interpreter.get_executed_count();
+    }
+    return best;
+}
+
+int run_microbenchmarks(const std::string& directory) {
+    std::vector<Microbenchmark> benches = {
+        { "push_var", "\"\" x; = y", {}, { { "", "x" }, { "=", "y" } }, {} },
+        { "=", "\"\" 1; = y", {}, { { "", "1" }, { "=", "y" } }, {} },
+        { "+", "\"\" 1; +", { { "", "acc" } }, { { "", "1" }, { "+" } }, { { "=", "acc" } } },
+        { "==", "\"\" 1; ==", { { "", "acc" } }, { { "", "1" }, { "==" } }, { { "=", "acc" } } },
+        { "jf_taken", "\"\" 0; jf next", {}, { { "", "0" }, { "jf", "2" } }, {} },
+        { "jf_not_taken", "\"\" 1; jf next", {}, { { "", "1" }, { "jf", "2" } }, {} },
+        { "array_get", "array_get a", { { "", "0" } }, { { "array_get", "a" } }, { { "=", "acc" } } },
+        { "array_set", "\"\" 3; \"\" x; array_set a", {}, { { "", "3" }, { "", "x" }, { "array_set", "a" } }, {} },
+    };
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    std::string results_file = (std::filesystem::path(directory) / "microbench.csv").string();
+    std::ofstream csv(results_file, std::ios::trunc);
+    if (!csv.is_open()) {
+        std::cerr << "Error: Cannot open file " << results_file << " for writing" << std::endl;
+        return 1;
+    }
+    csv << "compiler_version,operation,unit,instructions_per_unit,ns_per_instruction,ns_per_unit,ipc\n";
+
+    PerfCounters counters;
+    if (!counters.available()) {
+        std::cout << "perf_event_open is not available, IPC is not measured\n";
+    }
+    std::cout << std::left << std::setw(14) << "operation" << std::setw(28) << "unit" << std::right
+        << std::setw(10) << "ns/instr" << std::setw(10) << "ns/unit" << std::setw(8) << "IPC" << "\n";
+
+    // Накладные расходы самого цикла вычитаются: тот же цикл без повторений фрагмента.
+    MicroResult overhead = run_micro_program(build_micro_program({ "loop", "", {}, {}, {} }, 0), counters);
+    int failed = 0;
+    for (const auto& bench : benches) {
+        MicroResult r;
+        try {
+            r = run_micro_program(build_micro_program(bench, MICRO_UNROLL), counters);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error in microbenchmark " << bench.name << ": " << e.what() << "\n";
+            ++failed;
+            continue;
+        }
+        double units = static_cast<double>(MICRO_UNROLL) * MICRO_ITERATIONS;
+        double seconds = std::max(0.0, r.seconds - overhead.seconds);
+        double instructions = static_cast<double>(r.executed - overhead.executed);
+        double ns_per_instruction = instructions > 0 ? seconds * 1e9 / instructions : 0.0;
+        double ns_per_unit = seconds * 1e9 / units;
+        std::string unit_field;
+        for (char c : bench.unit) {
+            unit_field += (c == '"') ? "\"\"" : std::string(1, c);
+        }
+        csv << COMPILER_VERSION << "," << bench.name << ",\"" << unit_field << "\"," << bench.body.size() << ","
+            << ns_per_instruction << "," << ns_per_unit << ",";
+        if (counters.available()) csv << r.ipc;
+        csv << "\n";
+        std::cout << std::left << std::setw(14) << bench.name << std::setw(28) << bench.unit << std::right
+            << std::fixed << std::setprecision(2) << std::setw(10) << ns_per_instruction << std::setw(10) << ns_per_unit;
+        if (counters.available()) std::cout << std::setw(8) << r.ipc;
+        else std::cout << std::setw(8) << "n/a";
+        std::cout << "\n";
+        std::cout.unsetf(std::ios::fixed);
+    }
+    std::cout << "=== Microbenchmark results written to " << results_file << " ===\n";
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+
+// Генераторы программ для измерений; размер задаёт объём работы.
+std::string generate_declarations_program(size_t count);    // count объявлений переменных и массивов
+std::string generate_nested_program(size_t depth);          // вложенные while/if глубины depth
+std::string generate_expression_program(size_t terms);      // длинное арифметическое выражение в цикле
+std::string generate_sort_program();                        // пузырьковая сортировка, n и элементы читаются
+std::string generate_sort_input(size_t count, unsigned seed);
+
+// Генерирует программы в каталог directory, замеряет лексер, парсер, оптимизатор и
+// интерпретатор по отдельности и пишет результаты в directory/results.csv.
+int run_benchmarks(const std::string& directory);
+
+// Микроизмерения отдельных операций ОПС: на каждую операцию — цикл из развёрнутых
+// повторений короткого фрагмента. Печатает нс на инструкцию и IPC (если доступны
+// счётчики perf_event_open), результаты пишет в directory/microbench.csv.
+int run_microbenchmarks(const std::string& directory);
+
+#endif // BENCHMARK_H
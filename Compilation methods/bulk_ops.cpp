@@ -0,0 +1,254 @@
+#include "bulk_ops.h"
+#include <algorithm>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BULK_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define BULK_AVX2_TARGET
+#else
+#define BULK_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+// Знаковое переполнение в C++ — UB, поэтому скалярные варианты считают в unsigned.
+static inline int wrap_add(int a, int b) { return static_cast<int>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b)); }
+static inline int wrap_sub(int a, int b) { return static_cast<int>(static_cast<uint32_t>(a) - static_cast<uint32_t>(b)); }
+static inline int wrap_mul(int a, int b) { return static_cast<int>(static_cast<uint32_t>(a) * static_cast<uint32_t>(b)); }
+
+static bool detect_avx2() {
+#if defined(BULK_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false; // ОС сохраняет регистры YMM
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(BULK_X86)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+bool bulk_has_avx2() {
+    static const bool has_avx2 = detect_avx2();
+    return has_avx2;
+}
+
+#ifdef BULK_X86
+BULK_AVX2_TARGET static void fill_avx2(int* dst, size_t n, int value) {
+    __m256i v = _mm256_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+    for (; i < n; ++i) dst[i] = value;
+}
+
+BULK_AVX2_TARGET static void copy_avx2(int* dst, const int* src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+    }
+    for (; i < n; ++i) dst[i] = src[i];
+}
+
+BULK_AVX2_TARGET static void add_scalar_avx2(int* dst, size_t n, int value) {
+    __m256i v = _mm256_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i* p = reinterpret_cast<__m256i*>(dst + i);
+        _mm256_storeu_si256(p, _mm256_add_epi32(_mm256_loadu_si256(p), v));
+    }
+    for (; i < n; ++i) dst[i] = wrap_add(dst[i], value);
+}
+
+BULK_AVX2_TARGET static void sub_scalar_avx2(int* dst, size_t n, int value) {
+    __m256i v = _mm256_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i* p = reinterpret_cast<__m256i*>(dst + i);
+        _mm256_storeu_si256(p, _mm256_sub_epi32(_mm256_loadu_si256(p), v));
+    }
+    for (; i < n; ++i) dst[i] = wrap_sub(dst[i], value);
+}
+
+BULK_AVX2_TARGET static void mul_scalar_avx2(int* dst, size_t n, int value) {
+    __m256i v = _mm256_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i* p = reinterpret_cast<__m256i*>(dst + i);
+        _mm256_storeu_si256(p, _mm256_mullo_epi32(_mm256_loadu_si256(p), v));
+    }
+    for (; i < n; ++i) dst[i] = wrap_mul(dst[i], value);
+}
+
+BULK_AVX2_TARGET static void add_array_avx2(int* dst, const int* src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i* p = reinterpret_cast<__m256i*>(dst + i);
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(p, _mm256_add_epi32(_mm256_loadu_si256(p), s));
+    }
+    for (; i < n; ++i) dst[i] = wrap_add(dst[i], src[i]);
+}
+
+BULK_AVX2_TARGET static void sub_array_avx2(int* dst, const int* src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i* p = reinterpret_cast<__m256i*>(dst + i);
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(p, _mm256_sub_epi32(_mm256_loadu_si256(p), s));
+    }
+    for (; i < n; ++i) dst[i] = wrap_sub(dst[i], src[i]);
+}
+
+BULK_AVX2_TARGET static void mul_array_avx2(int* dst, const int* src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i* p = reinterpret_cast<__m256i*>(dst + i);
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(p, _mm256_mullo_epi32(_mm256_loadu_si256(p), s));
+    }
+    for (; i < n; ++i) dst[i] = wrap_mul(dst[i], src[i]);
+}
+
+BULK_AVX2_TARGET static int sum_avx2(const int* src, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_add_epi32(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+    }
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    int result = _mm_cvtsi128_si32(s);
+    for (; i < n; ++i) result = wrap_add(result, src[i]);
+    return result;
+}
+
+BULK_AVX2_TARGET static int min_avx2(const int* src, size_t n) {
+    int result = src[0];
+    size_t i = 0;
+    if (n >= 8) {
+        __m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+        for (i = 8; i + 8 <= n; i += 8) {
+            acc = _mm256_min_epi32(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+        }
+        __m128i s = _mm_min_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        s = _mm_min_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+        s = _mm_min_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+        result = _mm_cvtsi128_si32(s);
+    }
+    for (; i < n; ++i) result = std::min(result, src[i]);
+    return result;
+}
+
+BULK_AVX2_TARGET static int max_avx2(const int* src, size_t n) {
+    int result = src[0];
+    size_t i = 0;
+    if (n >= 8) {
+        __m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+        for (i = 8; i + 8 <= n; i += 8) {
+            acc = _mm256_max_epi32(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+        }
+        __m128i s = _mm_max_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        s = _mm_max_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+        s = _mm_max_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+        result = _mm_cvtsi128_si32(s);
+    }
+    for (; i < n; ++i) result = std::max(result, src[i]);
+    return result;
+}
+#endif // BULK_X86
+
+void bulk_fill(int* dst, size_t n, int value) {
+#ifdef BULK_X86
+    if (bulk_has_avx2()) { fill_avx2(dst, n, value); return; }
+#endif
+    std::fill(dst, dst + n, value);
+}
+
+void bulk_copy(int* dst, const int* src, size_t n) {
+#ifdef BULK_X86
+    if (bulk_has_avx2()) { copy_avx2(dst, src, n); return; }
+#endif
+    std::copy(src, src + n, dst);
+}
+
+void bulk_add_scalar(int* dst, size_t n, int value) {
+#ifdef BULK_X86
+    if (bulk_has_avx2()) { add_scalar_avx2(dst, n, value); return; }
+#endif
+    for (size_t i = 0; i < n; ++i) dst[i] = wrap_add(dst[i], value);
+}
+
+void bulk_sub_scalar(int* dst, size_t n, int value) {
+#ifdef BULK_X86
+    if (bulk_has_avx2()) { sub_scalar_avx2(dst, n, value); return; }
+#endif
+    for (size_t i = 0; i < n; ++i) dst[i] = wrap_sub(dst[i], value);
+}
+
+void bulk_mul_scalar(int* dst, size_t n, int value) {
+#ifdef BULK_X86
+    if (bulk_has_avx2()) { mul_scalar_avx2(dst, n, value); return; }
+#endif
+    for (size_t i = 0; i < n; ++i) dst[i] = wrap_mul(dst[i], value);
+}
+
+void bulk_add_array(int* dst, const int* src, size_t n) {
+#ifdef BULK_X86
+    if (bulk_has_avx2()) { add_array_avx2(dst, src, n); return; }
+#endif
+    for (size_t i = 0; i < n; ++i) dst[i] = wrap_add(dst[i], src[i]);
+}
+
+void bulk_sub_array(int* dst, const int* src, size_t n) {
+#ifdef BULK_X86
+    if (bulk_has_avx2()) { sub_array_avx2(dst, src, n); return; }
+#endif
+    for (size_t i = 0; i < n; ++i) dst[i] = wrap_sub(dst[i], src[i]);
+}
+
+void bulk_mul_array(int* dst, const int* src, size_t n) {
+#ifdef BULK_X86
+    if (bulk_has_avx2()) { mul_array_avx2(dst, src, n); return; }
+#endif
+    for (size_t i = 0; i < n; ++i) dst[i] = wrap_mul(dst[i], src[i]);
+}
+
+int bulk_sum(const int* src, size_t n) {
+#ifdef BULK_X86
+    if (bulk_has_avx2()) return sum_avx2(src, n);
+#endif
+    int result = 0;
+    for (size_t i = 0; i < n; ++i) result = wrap_add(result, src[i]);
+    return result;
+}
+
+int bulk_min(const int* src, size_t n) {
+#ifdef BULK_X86
+    if (bulk_has_avx2()) return min_avx2(src, n);
+#endif
+    return *std::min_element(src, src + n);
+}
+
+int bulk_max(const int* src, size_t n) {
+#ifdef BULK_X86
+    if (bulk_has_avx2()) return max_avx2(src, n);
+#endif
+    return *std::max_element(src, src + n);
+}
+
+void bulk_sort(int* dst, size_t n) {
+    // Отдельного SIMD-ядра нет: главный выигрыш — O(n log n) вместо пузырька,
+    // написанного на самом языке.
+    std::sort(dst, dst + n);
+}
@@ -0,0 +1,28 @@
+#ifndef BULK_OPS_H
+#define BULK_OPS_H
+
+#include <cstddef>
+
+// Векторные ядра для массовых операций над массивами (AVX2, если процессор
+// его поддерживает, иначе скалярный вариант). Арифметика — с переполнением
+// по модулю 2^32, как у 32-битных SIMD-инструкций.
+bool bulk_has_avx2();
+
+void bulk_fill(int* dst, size_t n, int value);
+void bulk_copy(int* dst, const int* src, size_t n);
+
+void bulk_add_scalar(int* dst, size_t n, int value);
+void bulk_sub_scalar(int* dst, size_t n, int value);
+void bulk_mul_scalar(int* dst, size_t n, int value);
+
+void bulk_add_array(int* dst, const int* src, size_t n);
+void bulk_sub_array(int* dst, const int* src, size_t n);
+void bulk_mul_array(int* dst, const int* src, size_t n);
+
+int bulk_sum(const int* src, size_t n);
+int bulk_min(const int* src, size_t n); // n > 0
+int bulk_max(const int* src, size_t n); // n > 0
+
+void bulk_sort(int* dst, size_t n);
+
+#endif // BULK_OPS_H
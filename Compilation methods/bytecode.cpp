@@ -0,0 +1,578 @@
+#include "bytecode.h"
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(BytecodeHeader) == 56, "BytecodeHeader layout is part of the file format");
+static_assert(sizeof(Opcode) == 1, "Opcode layout is part of the file format");
+static_assert(sizeof(BytecodeSymbol) == 16, "BytecodeSymbol layout is part of the file format");
+
+// Инструкция при переводе ОПС; в образ записывается двумя массивами.
+struct Instruction {
+    Opcode opcode;
+    int32_t operand;
+};
+
+struct OpcodeInfo {
+    const char* name; // операция ОПС
+    OperandKind operand;
+};
+
+static const OpcodeInfo OPCODE_INFO[] = {
+    { "", OperandKind::SYMBOL },               // PUSH_VAR
+    { "", OperandKind::CONSTANT },             // PUSH_CONST
+    { "+", OperandKind::NONE },
+    { "-", OperandKind::NONE },
+    { "*", OperandKind::NONE },
+    { "/", OperandKind::NONE },
+    { "~", OperandKind::NONE },
+    { ">", OperandKind::NONE },
+    { "<", OperandKind::NONE },
+    { "==", OperandKind::NONE },
+    { "&", OperandKind::NONE },
+    { "|", OperandKind::NONE },
+    { "!", OperandKind::NONE },
+    { "jf", OperandKind::TARGET },
+    { "j", OperandKind::TARGET },
+    { "=", OperandKind::SYMBOL },
+    { "r", OperandKind::SYMBOL },
+    { "w", OperandKind::NONE },
+    { "alloc_array", OperandKind::SYMBOL },
+    { "init_array", OperandKind::INIT },
+    { "array_read", OperandKind::SYMBOL },
+    { "array_get", OperandKind::SYMBOL },
+    { "array_set", OperandKind::SYMBOL },
+    { "array_fill", OperandKind::SYMBOL },
+    { "array_add", OperandKind::SYMBOL },
+    { "array_sub", OperandKind::SYMBOL },
+    { "array_mul", OperandKind::SYMBOL },
+    { "array_copy", OperandKind::PAIR },
+    { "array_add_array", OperandKind::PAIR },
+    { "array_sub_array", OperandKind::PAIR },
+    { "array_mul_array", OperandKind::PAIR },
+    { "array_sort", OperandKind::SYMBOL },
+    { "array_sum", OperandKind::SYMBOL },
+    { "array_min", OperandKind::SYMBOL },
+    { "array_max", OperandKind::SYMBOL },
+    { "array_fill_range", OperandKind::SYMBOL },
+    { "array_copy_range", OperandKind::PAIR },
+    { "array_read_range", OperandKind::SYMBOL },
+    { "array_print_range", OperandKind::SYMBOL },
+    { "array_get_unchecked", OperandKind::SYMBOL },
+    { "array_set_unchecked", OperandKind::SYMBOL },
+    { "jt", OperandKind::TARGET },
+    { "shl", OperandKind::CONSTANT },
+    { "div_const", OperandKind::DIVISOR },
+};
+
+static_assert(sizeof(OPCODE_INFO) / sizeof(OPCODE_INFO[0]) == static_cast<size_t>(Opcode::COUNT), "OPCODE_INFO must cover every opcode");
+
+const char* get_opcode_name(Opcode opcode) {
+    return OPCODE_INFO[static_cast<size_t>(opcode)].name;
+}
+
+OperandKind get_operand_kind(Opcode opcode) {
+    return OPCODE_INFO[static_cast<size_t>(opcode)].operand;
+}
+
+void compute_division_magic(int32_t divisor, int32_t& magic, int32_t& shift) {
+    const uint32_t two31 = 0x80000000u;
+    const uint32_t d = static_cast<uint32_t>(divisor);
+    const uint32_t anc = two31 - 1 - two31 % d;
+    uint32_t q1 = two31 / anc, r1 = two31 - q1 * anc;
+    uint32_t q2 = two31 / d, r2 = two31 - q2 * d;
+    int p = 31;
+    uint32_t delta = 0;
+    do {
+        ++p;
+        q1 *= 2; r1 *= 2;
+        if (r1 >= anc) { ++q1; r1 -= anc; }
+        q2 *= 2; r2 *= 2;
+        if (r2 >= d) { ++q2; r2 -= d; }
+        delta = d - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+    magic = static_cast<int32_t>(q2 + 1);
+    shift = p - 32;
+}
+
+static size_t align8(size_t n) {
+    return (n + 7) & ~static_cast<size_t>(7);
+}
+
+BytecodeImage::BytecodeImage() : data(nullptr), size(0), mapping(nullptr), mapping_size(0)
+#ifdef _WIN32
+    , file_handle(nullptr), mapping_handle(nullptr)
+#endif
+{}
+
+BytecodeImage::~BytecodeImage() {
+    release();
+}
+
+BytecodeImage::BytecodeImage(BytecodeImage&& other) noexcept : BytecodeImage() {
+    *this = std::move(other);
+}
+
+BytecodeImage& BytecodeImage::operator=(BytecodeImage&& other) noexcept {
+    if (this != &other) {
+        release();
+        buffer = std::move(other.buffer);
+        data = other.data;
+        size = other.size;
+        mapping = other.mapping;
+        mapping_size = other.mapping_size;
+#ifdef _WIN32
+        file_handle = other.file_handle;
+        mapping_handle = other.mapping_handle;
+        other.file_handle = nullptr;
+        other.mapping_handle = nullptr;
+#endif
+        other.data = nullptr;
+        other.size = 0;
+        other.mapping = nullptr;
+        other.mapping_size = 0;
+    }
+    return *this;
+}
+
+void BytecodeImage::release() {
+#ifdef _WIN32
+    if (mapping) UnmapViewOfFile(mapping);
+    if (mapping_handle) CloseHandle(mapping_handle);
+    if (file_handle) CloseHandle(file_handle);
+    file_handle = nullptr;
+    mapping_handle = nullptr;
+#else
+    if (mapping) munmap(mapping, mapping_size);
+#endif
+    mapping = nullptr;
+    mapping_size = 0;
+    buffer.clear();
+    data = nullptr;
+    size = 0;
+}
+
+BytecodeImage BytecodeImage::from_buffer(std::vector<char> buffer) {
+    BytecodeImage image;
+    image.buffer = std::move(buffer);
+    image.data = image.buffer.data();
+    image.size = image.buffer.size();
+    image.validate(false);
+    return image;
+}
+
+BytecodeImage BytecodeImage::map_file(const std::string& path) {
+    BytecodeImage image;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Cannot open bytecode file " + path);
+    }
+    image.file_handle = file;
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        throw std::runtime_error("Invalid bytecode file " + path + ": empty file");
+    }
+    HANDLE mapping_handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_handle) {
+        throw std::runtime_error("Cannot map bytecode file " + path);
+    }
+    image.mapping_handle = mapping_handle;
+    image.mapping = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (!image.mapping) {
+        throw std::runtime_error("Cannot map bytecode file " + path);
+    }
+    image.mapping_size = static_cast<size_t>(file_size.QuadPart);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open bytecode file " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("Invalid bytecode file " + path + ": empty file");
+    }
+    void* mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map bytecode file " + path);
+    }
+    image.mapping = mapping;
+    image.mapping_size = static_cast<size_t>(st.st_size);
+#endif
+    image.data = static_cast<const char*>(image.mapping);
+    image.size = image.mapping_size;
+    image.validate(false);
+    return image;
+}
+
+void BytecodeImage::write_file(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file " + path + " for writing");
+    }
+    // Доказательство границ относится к программе, из которой образ получен; файл можно
+    // подменить, поэтому при загрузке такие инструкции запрещены (см. validate).
+    std::vector<char> image(data, data + size);
+    Opcode* codes = reinterpret_cast<Opcode*>(image.data() + header().opcodes_offset);
+    for (uint32_t pc = 0; pc < header().instruction_count; ++pc) {
+        if (codes[pc] == Opcode::ARRAY_GET_UNCHECKED) codes[pc] = Opcode::ARRAY_GET;
+        else if (codes[pc] == Opcode::ARRAY_SET_UNCHECKED) codes[pc] = Opcode::ARRAY_SET;
+    }
+    file.write(image.data(), static_cast<std::streamsize>(image.size()));
+    if (!file) {
+        throw std::runtime_error("Cannot write bytecode file " + path);
+    }
+}
+
+const BytecodeHeader& BytecodeImage::header() const {
+    return *reinterpret_cast<const BytecodeHeader*>(data);
+}
+
+const Opcode* BytecodeImage::opcodes() const {
+    return reinterpret_cast<const Opcode*>(data + header().opcodes_offset);
+}
+
+const int32_t* BytecodeImage::operands() const {
+    return reinterpret_cast<const int32_t*>(data + header().operands_offset);
+}
+
+const int32_t* BytecodeImage::constants() const {
+    return reinterpret_cast<const int32_t*>(data + header().constants_offset);
+}
+
+const BytecodeSymbol* BytecodeImage::symbols() const {
+    return reinterpret_cast<const BytecodeSymbol*>(data + header().symbols_offset);
+}
+
+const uint32_t* BytecodeImage::lines() const {
+    return reinterpret_cast<const uint32_t*>(data + header().lines_offset);
+}
+
+std::string BytecodeImage::get_symbol_name(uint32_t index) const {
+    const BytecodeSymbol& symbol = symbols()[index];
+    return std::string(data + header().names_offset + symbol.name_offset, symbol.name_length);
+}
+
+std::string BytecodeImage::get_operand_text(size_t pc) const {
+    int32_t operand = operands()[pc];
+    switch (get_operand_kind(opcodes()[pc])) {
+    case OperandKind::SYMBOL:
+        return get_symbol_name(static_cast<uint32_t>(operand));
+    case OperandKind::CONSTANT:
+    case OperandKind::DIVISOR:
+        return std::to_string(constants()[operand]);
+    case OperandKind::TARGET:
+        return std::to_string(operand);
+    case OperandKind::PAIR:
+        return get_symbol_name(static_cast<uint32_t>(constants()[operand])) + "," + get_symbol_name(static_cast<uint32_t>(constants()[operand + 1]));
+    case OperandKind::INIT:
+        return std::to_string(constants()[operand]);
+    default:
+        return "";
+    }
+}
+
+// Проверка выполняется один раз при загрузке, чтобы интерпретатор мог доверять индексам.
+// Инструкции без проверки границ допустимы только в образе, который только что построил
+// compile_bytecode по ОПС с доказанными индексами.
+void BytecodeImage::validate(bool allow_unchecked) const {
+    auto fail = [](const std::string& what) {
+        throw std::runtime_error("Invalid bytecode: " + what);
+    };
+    if (size < sizeof(BytecodeHeader)) fail("file too small");
+    if (reinterpret_cast<uintptr_t>(data) % 8 != 0) fail("misaligned image");
+    const BytecodeHeader& h = header();
+    if (std::memcmp(h.magic, "OPSB", 4) != 0) fail("bad magic");
+    if (h.version != BYTECODE_VERSION) fail("unsupported version " + std::to_string(h.version));
+    if (h.header_size != sizeof(BytecodeHeader) || h.total_size != size) fail("bad header size");
+
+    auto check_section = [&](uint32_t offset, uint64_t bytes, const char* name) {
+        if (offset % 8 != 0 || offset < sizeof(BytecodeHeader) || offset + bytes > size) {
+            fail(std::string("bad ") + name + " section");
+        }
+    };
+    check_section(h.opcodes_offset, uint64_t(h.instruction_count) * sizeof(Opcode), "opcodes");
+    check_section(h.operands_offset, uint64_t(h.instruction_count) * sizeof(int32_t), "operands");
+    check_section(h.constants_offset, uint64_t(h.constant_count) * sizeof(int32_t), "constants");
+    check_section(h.symbols_offset, uint64_t(h.symbol_count) * sizeof(BytecodeSymbol), "symbols");
+    check_section(h.lines_offset, uint64_t(h.instruction_count) * sizeof(uint32_t), "lines");
+    check_section(h.names_offset, h.name_bytes, "names");
+
+    for (uint32_t i = 0; i < h.symbol_count; ++i) {
+        const BytecodeSymbol& symbol = symbols()[i];
+        if (uint64_t(symbol.name_offset) + symbol.name_length > h.name_bytes) fail("symbol name out of range");
+        if (symbol.kind > SymbolKind::ARRAY) fail("bad symbol kind");
+    }
+    auto is_symbol = [&](int32_t index) {
+        return index >= 0 && static_cast<uint32_t>(index) < h.symbol_count;
+    };
+    for (uint32_t pc = 0; pc < h.instruction_count; ++pc) {
+        const Opcode opcode = opcodes()[pc];
+        if (opcode >= Opcode::COUNT) fail("unknown opcode at pc " + std::to_string(pc));
+        if (!allow_unchecked && (opcode == Opcode::ARRAY_GET_UNCHECKED || opcode == Opcode::ARRAY_SET_UNCHECKED)) {
+            fail("unchecked array access at pc " + std::to_string(pc));
+        }
+        int32_t operand = operands()[pc];
+        bool ok = true;
+        switch (get_operand_kind(opcode)) {
+        case OperandKind::SYMBOL:
+            ok = is_symbol(operand);
+            break;
+        case OperandKind::CONSTANT:
+            ok = operand >= 0 && static_cast<uint32_t>(operand) < h.constant_count;
+            if (ok && opcode == Opcode::SHL) ok = constants()[operand] >= 1 && constants()[operand] <= 30;
+            break;
+        case OperandKind::DIVISOR:
+            ok = operand >= 0 && static_cast<uint32_t>(operand) + 2 < h.constant_count && constants()[operand] >= 2;
+            if (ok) {
+                int32_t magic = 0, shift = 0;
+                compute_division_magic(constants()[operand], magic, shift);
+                ok = constants()[operand + 1] == magic && constants()[operand + 2] == shift;
+            }
+            break;
+        case OperandKind::TARGET:
+            ok = operand >= 0 && static_cast<uint32_t>(operand) <= h.instruction_count;
+            break;
+        case OperandKind::PAIR:
+            ok = operand >= 0 && static_cast<uint32_t>(operand) + 1 < h.constant_count
+                && is_symbol(constants()[operand]) && is_symbol(constants()[operand + 1]);
+            break;
+        case OperandKind::INIT:
+            ok = operand >= 0 && static_cast<uint32_t>(operand) + 1 < h.constant_count
+                && constants()[operand] >= 0 && (constants()[operand + 1] == -1 || is_symbol(constants()[operand + 1]));
+            break;
+        default:
+            break;
+        }
+        if (!ok) fail("bad operand at pc " + std::to_string(pc));
+    }
+}
+
+BytecodeImage compile_bytecode(const std::vector<OPS>& ops, const SymbolTable& sym_table) {
+    static const std::map<std::string, Opcode> opcodes = [] {
+        std::map<std::string, Opcode> table;
+        for (size_t i = static_cast<size_t>(Opcode::ADD); i < static_cast<size_t>(Opcode::COUNT); ++i) {
+            table[OPCODE_INFO[i].name] = static_cast<Opcode>(i);
+        }
+        return table;
+    }();
+
+    std::vector<Opcode> instruction_opcodes;
+    std::vector<int32_t> instruction_operands;
+    std::vector<int32_t> constants;
+    std::vector<BytecodeSymbol> symbols;
+    std::vector<uint32_t> lines;
+    std::string names;
+    std::map<std::string, int32_t> symbol_index;
+    std::map<int32_t, int32_t> constant_index;
+
+    auto add_symbol = [&](const std::string& name) {
+        auto it = symbol_index.find(name);
+        if (it != symbol_index.end()) return it->second;
+        int32_t index = static_cast<int32_t>(symbols.size());
+        SymbolKind kind = sym_table.get_variables().count(name) || is_temporary_variable(name) ? SymbolKind::VARIABLE : SymbolKind::UNKNOWN;
+        symbols.push_back({ static_cast<uint32_t>(names.size()), static_cast<uint32_t>(name.size()), kind, -1 });
+        names += name;
+        symbol_index[name] = index;
+        return index;
+    };
+    auto add_array_symbol = [&](const std::string& name) {
+        int32_t index = add_symbol(name);
+        if (symbols[index].kind == SymbolKind::UNKNOWN) symbols[index].kind = SymbolKind::ARRAY;
+        return index;
+    };
+    auto add_constant = [&](int32_t value) {
+        auto it = constant_index.find(value);
+        if (it != constant_index.end()) return it->second;
+        int32_t index = static_cast<int32_t>(constants.size());
+        constants.push_back(value);
+        constant_index[value] = index;
+        return index;
+    };
+
+    for (size_t pc = 0; pc < ops.size(); ++pc) {
+        const OPS& op = ops[pc];
+        Instruction instruction = {};
+        if (op.operation.empty()) {
+            // Число или имя переменной; ошибки (массив вместо переменной, неверное число)
+            // выдаются при выполнении, как и раньше.
+            bool is_number = false;
+            int value = 0;
+            if (!sym_table.exists(op.operand)) {
+                try {
+                    value = std::stoi(op.operand);
+                    is_number = true;
+                }
+                catch (const std::exception&) {
+                }
+            }
+            if (is_number) {
+                instruction.opcode = Opcode::PUSH_CONST;
+                instruction.operand = add_constant(value);
+            }
+            else {
+                instruction.opcode = Opcode::PUSH_VAR;
+                instruction.operand = add_symbol(op.operand);
+            }
+        }
+        else {
+            auto it = opcodes.find(op.operation);
+            if (it == opcodes.end()) {
+                throw std::runtime_error("Unknown operation: " + op.operation + " at pc " + std::to_string(pc));
+            }
+            instruction.opcode = it->second;
+            switch (get_operand_kind(instruction.opcode)) {
+            case OperandKind::SYMBOL:
+                if (instruction.opcode == Opcode::ASSIGN || instruction.opcode == Opcode::READ) {
+                    instruction.operand = add_symbol(op.operand);
+                }
+                else {
+                    instruction.operand = add_array_symbol(op.operand);
+                }
+                break;
+            case OperandKind::TARGET: {
+                if (op.operand.empty()) throw std::runtime_error(op.operation + " missing target operand at pc " + std::to_string(pc));
+                size_t target = 0;
+                try {
+                    target = std::stoul(op.operand);
+                }
+                catch (const std::exception&) {
+                    throw std::runtime_error("Invalid target for " + op.operation + ": " + op.operand + " at pc " + std::to_string(pc));
+                }
+                if (target > ops.size()) {
+                    throw std::runtime_error("Target out of range for " + op.operation + ": " + op.operand + " at pc " + std::to_string(pc));
+                }
+                instruction.operand = static_cast<int32_t>(target);
+                break;
+            }
+            case OperandKind::CONSTANT:
+            case OperandKind::DIVISOR: {
+                int value = 0;
+                try {
+                    value = std::stoi(op.operand);
+                }
+                catch (const std::exception&) {
+                    throw std::runtime_error("Invalid operand for " + op.operation + ": " + op.operand + " at pc " + std::to_string(pc));
+                }
+                if (get_operand_kind(instruction.opcode) == OperandKind::CONSTANT) {
+                    instruction.operand = add_constant(value);
+                    break;
+                }
+                if (value < 2) throw std::runtime_error("Invalid divisor for div_const: " + op.operand + " at pc " + std::to_string(pc));
+                int32_t magic = 0, shift = 0;
+                compute_division_magic(value, magic, shift);
+                instruction.operand = static_cast<int32_t>(constants.size());
+                constants.push_back(value);
+                constants.push_back(magic);
+                constants.push_back(shift);
+                break;
+            }
+            case OperandKind::PAIR: {
+                size_t comma = op.operand.find(',');
+                if (comma == std::string::npos) {
+                    throw std::runtime_error("Invalid array pair operand: " + op.operand + " at pc " + std::to_string(pc));
+                }
+                int32_t dst = add_array_symbol(op.operand.substr(0, comma));
+                int32_t src = add_array_symbol(op.operand.substr(comma + 1));
+                instruction.operand = static_cast<int32_t>(constants.size());
+                constants.push_back(dst);
+                constants.push_back(src);
+                break;
+            }
+            case OperandKind::INIT: {
+                int count = 0;
+                try {
+                    count = std::stoi(op.operand);
+                }
+                catch (const std::exception&) {
+                    throw std::runtime_error("Invalid operand for init_array: " + op.operand + " at pc " + std::to_string(pc));
+                }
+                if (count < 0) throw std::runtime_error("Negative number of initializers for init_array at pc " + std::to_string(pc));
+                // Массив — ближайший предшествующий alloc_array (так его искал интерпретатор ОПС).
+                int32_t array = -1;
+                for (size_t k = pc; k-- > 0;) {
+                    if (ops[k].operation == "alloc_array") {
+                        array = add_array_symbol(ops[k].operand);
+                        break;
+                    }
+                }
+                instruction.operand = static_cast<int32_t>(constants.size());
+                constants.push_back(count);
+                constants.push_back(array);
+                break;
+            }
+            default:
+                break;
+            }
+            // Размер массива известен, если перед alloc_array стоит число.
+            if (instruction.opcode == Opcode::ALLOC_ARRAY && pc > 0 && ops[pc - 1].operation.empty()) {
+                try {
+                    symbols[instruction.operand].array_size = std::stoi(ops[pc - 1].operand);
+                }
+                catch (const std::exception&) {
+                }
+            }
+        }
+        instruction_opcodes.push_back(instruction.opcode);
+        instruction_operands.push_back(instruction.operand);
+        lines.push_back(static_cast<uint32_t>(op.line));
+    }
+
+    BytecodeHeader header = {};
+    std::memcpy(header.magic, "OPSB", 4);
+    header.version = BYTECODE_VERSION;
+    header.header_size = sizeof(BytecodeHeader);
+    header.instruction_count = static_cast<uint32_t>(instruction_opcodes.size());
+    header.constant_count = static_cast<uint32_t>(constants.size());
+    header.symbol_count = static_cast<uint32_t>(symbols.size());
+    header.name_bytes = static_cast<uint32_t>(names.size());
+    size_t offset = align8(sizeof(BytecodeHeader));
+    header.opcodes_offset = static_cast<uint32_t>(offset);
+    offset = align8(offset + instruction_opcodes.size() * sizeof(Opcode));
+    header.operands_offset = static_cast<uint32_t>(offset);
+    offset = align8(offset + instruction_operands.size() * sizeof(int32_t));
+    header.constants_offset = static_cast<uint32_t>(offset);
+    offset = align8(offset + constants.size() * sizeof(int32_t));
+    header.symbols_offset = static_cast<uint32_t>(offset);
+    offset = align8(offset + symbols.size() * sizeof(BytecodeSymbol));
+    header.lines_offset = static_cast<uint32_t>(offset);
+    offset = align8(offset + lines.size() * sizeof(uint32_t));
+    header.names_offset = static_cast<uint32_t>(offset);
+    offset = align8(offset + names.size());
+    header.total_size = static_cast<uint32_t>(offset);
+
+    std::vector<char> buffer(offset, 0);
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    if (!instruction_opcodes.empty()) std::memcpy(buffer.data() + header.opcodes_offset, instruction_opcodes.data(), instruction_opcodes.size() * sizeof(Opcode));
+    if (!instruction_operands.empty()) std::memcpy(buffer.data() + header.operands_offset, instruction_operands.data(), instruction_operands.size() * sizeof(int32_t));
+    if (!constants.empty()) std::memcpy(buffer.data() + header.constants_offset, constants.data(), constants.size() * sizeof(int32_t));
+    if (!symbols.empty()) std::memcpy(buffer.data() + header.symbols_offset, symbols.data(), symbols.size() * sizeof(BytecodeSymbol));
+    if (!lines.empty()) std::memcpy(buffer.data() + header.lines_offset, lines.data(), lines.size() * sizeof(uint32_t));
+    if (!names.empty()) std::memcpy(buffer.data() + header.names_offset, names.data(), names.size());
+    BytecodeImage image;
+    image.buffer = std::move(buffer);
+    image.data = image.buffer.data();
+    image.size = image.buffer.size();
+    image.validate(true);
+    return image;
+}
+
+void disassemble(const BytecodeImage& image, std::ostream& out) {
+    const Opcode* opcodes = image.opcodes();
+    for (size_t pc = 0; pc < image.header().instruction_count; ++pc) {
+        std::string text = image.get_operand_text(pc);
+        out << pc << ": " << get_opcode_name(opcodes[pc]) << (text.empty() ? "" : " " + text) << "\n";
+    }
+}
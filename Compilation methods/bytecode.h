@@ -0,0 +1,134 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "ops.h"
+#include "symbol_table.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Байткод — ОПС, в которой строки заменены индексами. Файл байткода имеет ту же
+// раскладку, что и образ в памяти, поэтому интерпретатор выполняет его прямо из
+// отображённого в память файла. Все числа — little-endian.
+// Инструкции хранятся параллельными массивами: байт кода операции и 32-битный
+// операнд (5 байт на инструкцию), номера строк — отдельной секцией.
+#define BYTECODE_VERSION 2
+
+enum class Opcode : uint8_t {
+    PUSH_VAR, PUSH_CONST,
+    ADD, SUB, MUL, DIV, NEG, GT, LT, EQ, AND, OR, NOT,
+    JF, J, ASSIGN, READ, WRITE,
+    ALLOC_ARRAY, INIT_ARRAY, ARRAY_READ, ARRAY_GET, ARRAY_SET,
+    ARRAY_FILL, ARRAY_ADD, ARRAY_SUB, ARRAY_MUL,
+    ARRAY_COPY, ARRAY_ADD_ARRAY, ARRAY_SUB_ARRAY, ARRAY_MUL_ARRAY,
+    ARRAY_SORT, ARRAY_SUM, ARRAY_MIN, ARRAY_MAX,
+    ARRAY_FILL_RANGE, ARRAY_COPY_RANGE, ARRAY_READ_RANGE, ARRAY_PRINT_RANGE,
+    ARRAY_GET_UNCHECKED, ARRAY_SET_UNCHECKED,
+    JT, SHL, DIV_CONST,
+    COUNT
+};
+
+// Смысл операнда инструкции.
+enum class OperandKind {
+    NONE,
+    SYMBOL,   // индекс в таблице символов
+    CONSTANT, // индекс в пуле констант
+    TARGET,   // номер инструкции перехода
+    PAIR,     // индекс k в пуле констант: [k] — приёмник, [k+1] — источник (индексы символов)
+    INIT,     // индекс k в пуле констант: [k] — число значений, [k+1] — символ массива или -1
+    DIVISOR   // индекс k в пуле констант: [k] — делитель d >= 2, [k+1], [k+2] — множитель и сдвиг для d
+};
+
+enum class SymbolKind : uint32_t {
+    UNKNOWN, VARIABLE, ARRAY
+};
+
+struct BytecodeHeader {
+    char magic[4]; // "OPSB"
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t total_size;
+    uint32_t instruction_count;
+    uint32_t constant_count;
+    uint32_t symbol_count;
+    uint32_t name_bytes;
+    uint32_t opcodes_offset;  // Opcode на каждую инструкцию
+    uint32_t operands_offset; // int32_t на каждую инструкцию
+    uint32_t constants_offset;
+    uint32_t symbols_offset;
+    uint32_t lines_offset; // номер строки исходного текста для каждой инструкции
+    uint32_t names_offset;
+};
+
+struct BytecodeSymbol {
+    uint32_t name_offset;
+    uint32_t name_length;
+    SymbolKind kind;
+    int32_t array_size; // размер из объявления, если он задан числом, иначе -1
+};
+
+const char* get_opcode_name(Opcode opcode);
+OperandKind get_operand_kind(Opcode opcode);
+
+// Деление на константу d >= 2 без idiv: x / d == (mulhi(magic, x) [+ x]) >> shift, плюс 1
+// для отрицательных x — то же округление к нулю, что и у / в C++ (Hacker's Delight, 10-1).
+void compute_division_magic(int32_t divisor, int32_t& magic, int32_t& shift);
+inline int32_t divide_by_magic(int32_t x, int32_t magic, int32_t shift) {
+    int32_t q = static_cast<int32_t>((static_cast<int64_t>(magic) * x) >> 32);
+    if (magic < 0) q = static_cast<int32_t>(static_cast<uint32_t>(q) + static_cast<uint32_t>(x));
+    return (q >> shift) + static_cast<int32_t>(static_cast<uint32_t>(x) >> 31);
+}
+
+// Образ байткода: либо собственный буфер, либо отображённый в память файл.
+class BytecodeImage {
+public:
+    BytecodeImage();
+    ~BytecodeImage();
+    BytecodeImage(BytecodeImage&& other) noexcept;
+    BytecodeImage& operator=(BytecodeImage&& other) noexcept;
+    BytecodeImage(const BytecodeImage&) = delete;
+    BytecodeImage& operator=(const BytecodeImage&) = delete;
+
+    // Образы извне (буфер, файл) не могут содержать array_get_unchecked/array_set_unchecked:
+    // индекс в них не доказан, а обработчики этих инструкций границы не проверяют.
+    static BytecodeImage from_buffer(std::vector<char> buffer);
+    static BytecodeImage map_file(const std::string& path);
+    // В файл инструкции без проверки границ записываются как обычные array_get/array_set.
+    void write_file(const std::string& path) const;
+
+    const BytecodeHeader& header() const;
+    const Opcode* opcodes() const;
+    const int32_t* operands() const;
+    const int32_t* constants() const;
+    const BytecodeSymbol* symbols() const;
+    const uint32_t* lines() const;
+    std::string get_symbol_name(uint32_t index) const;
+    // Операнд инструкции в текстовом виде ОПС (как его печатает парсер).
+    std::string get_operand_text(size_t pc) const;
+
+private:
+    friend BytecodeImage compile_bytecode(const std::vector<OPS>& ops, const SymbolTable& sym_table);
+
+    void release();
+    void validate(bool allow_unchecked) const;
+
+    std::vector<char> buffer;
+    const char* data;
+    size_t size;
+    void* mapping;
+    size_t mapping_size;
+#ifdef _WIN32
+    void* file_handle;
+    void* mapping_handle;
+#endif
+};
+
+// Перевод ОПС в байткод. Переменные, объявленные парсером, берутся из sym_table.
+BytecodeImage compile_bytecode(const std::vector<OPS>& ops, const SymbolTable& sym_table);
+
+// Печатает инструкции в том же виде, в каком парсер в подробном режиме печатает ОПС:
+// "номер: операция операнд".
+void disassemble(const BytecodeImage& image, std::ostream& out);
+
+#endif // BYTECODE_H
@@ -0,0 +1,163 @@
+#include "compilation_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+static const char* const CACHE_MAGIC = "OPSCACHE";
+
+// FNV-1a, 64 бита.
+static uint64_t hash_bytes(uint64_t hash, const std::string& data) {
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+CompilationCache::CompilationCache(const std::string& directory, uint64_t size_limit)
+    : directory(directory), size_limit(size_limit), hits(0), misses(0) {
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+}
+
+std::string CompilationCache::entry_path(const std::string& code, bool optimized) const {
+    uint64_t hash = 14695981039346656037ULL;
+    hash = hash_bytes(hash, COMPILER_VERSION);
+    hash = hash_bytes(hash, optimized ? "+opt" : "-opt");
+    hash = hash_bytes(hash, code);
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.ops", static_cast<unsigned long long>(hash));
+    return (fs::path(directory) / name).string();
+}
+
+bool CompilationCache::load(const std::string& code, bool optimized, CompiledProgram& program) {
+    std::string path = entry_path(code, optimized);
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        ++misses;
+        return false;
+    }
+
+    // Запись проверяется целиком: совпадение хеша без совпадения текста — промах.
+    std::string magic, version;
+    int stored_optimized = -1;
+    size_t code_size = 0;
+    file >> magic >> version >> stored_optimized >> code_size;
+    file.get();
+    std::string stored_code(code_size, '\0');
+    file.read(&stored_code[0], static_cast<std::streamsize>(code_size));
+    if (!file || magic != CACHE_MAGIC || version != COMPILER_VERSION
+        || stored_optimized != (optimized ? 1 : 0) || stored_code != code) {
+        ++misses;
+        return false;
+    }
+
+    CompiledProgram loaded;
+    size_t count = 0;
+    file >> count;
+    for (size_t i = 0; i < count && file; ++i) {
+        std::string name;
+        file >> name;
+        loaded.variables.push_back(name);
+    }
+    file >> count;
+    file.get();
+    std::string line;
+    for (size_t i = 0; i < count && std::getline(file, line); ++i) {
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos) break;
+        size_t line_tab = line.find('\t', tab + 1);
+        if (line_tab == std::string::npos) break;
+        loaded.ops.emplace_back(line.substr(0, tab), line.substr(tab + 1, line_tab - tab - 1), std::atoi(line.c_str() + line_tab + 1));
+    }
+    if (loaded.ops.size() != count) {
+        ++misses;
+        return false;
+    }
+
+    // Время изменения записи служит отметкой последнего использования для LRU.
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    program = std::move(loaded);
+    ++hits;
+    return true;
+}
+
+void CompilationCache::store(const std::string& code, bool optimized, const CompiledProgram& program) {
+    std::string path = entry_path(code, optimized);
+    // Запись через временный файл и переименование: параллельные задания пакетного
+    // режима не увидят недописанную запись.
+    std::ostringstream tmp_name;
+    tmp_name << path << "." << std::hash<std::thread::id>()(std::this_thread::get_id()) << ".tmp";
+    {
+        std::ofstream file(tmp_name.str(), std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return;
+        file << CACHE_MAGIC << " " << COMPILER_VERSION << " " << (optimized ? 1 : 0) << " " << code.size() << "\n";
+        file << code << "\n";
+        file << program.variables.size() << "\n";
+        for (const auto& name : program.variables) {
+            file << name << "\n";
+        }
+        file << program.ops.size() << "\n";
+        for (const auto& op : program.ops) {
+            file << op.operation << "\t" << op.operand << "\t" << op.line << "\n";
+        }
+        if (!file) {
+            file.close();
+            std::error_code ec;
+            fs::remove(tmp_name.str(), ec);
+            return;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp_name.str(), path, ec);
+    if (ec) {
+        fs::remove(tmp_name.str(), ec);
+        return;
+    }
+    evict();
+}
+
+void CompilationCache::evict() {
+    std::lock_guard<std::mutex> lock(evict_mutex);
+    struct Entry {
+        fs::path path;
+        uint64_t size;
+        fs::file_time_type used;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() != ".ops") continue;
+        std::error_code entry_ec;
+        uint64_t size = it->file_size(entry_ec);
+        fs::file_time_type used = it->last_write_time(entry_ec);
+        if (entry_ec) continue;
+        entries.push_back({ it->path(), size, used });
+        total += size;
+    }
+    if (total <= size_limit) return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+    for (const auto& entry : entries) {
+        if (total <= size_limit) break;
+        if (fs::remove(entry.path, ec)) {
+            total -= entry.size;
+        }
+    }
+}
+
+size_t CompilationCache::get_hits() const {
+    return hits;
+}
+
+size_t CompilationCache::get_misses() const {
+    return misses;
+}
@@ -0,0 +1,42 @@
+#ifndef COMPILATION_CACHE_H
+#define COMPILATION_CACHE_H
+
+#include "ops.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Версия компилятора входит в ключ кэша: при изменении парсера или оптимизатора
+// её нужно увеличить, иначе из кэша будет загружена ОПС, построенная старым кодом.
+#define COMPILER_VERSION "1.12"
+
+// Результат компиляции, который можно выполнить без лексера и парсера.
+struct CompiledProgram {
+    std::vector<std::string> variables; // объявленные переменные (массивы создаются alloc_array)
+    std::vector<OPS> ops;
+};
+
+// Дисковый кэш готовой ОПС. Ключ — хеш текста программы, версии компилятора и
+// режима оптимизации; при превышении лимита удаляются давно не использованные записи.
+class CompilationCache {
+public:
+    CompilationCache(const std::string& directory, uint64_t size_limit);
+    bool load(const std::string& code, bool optimized, CompiledProgram& program);
+    void store(const std::string& code, bool optimized, const CompiledProgram& program);
+    size_t get_hits() const;
+    size_t get_misses() const;
+
+private:
+    std::string entry_path(const std::string& code, bool optimized) const;
+    void evict();
+
+    std::string directory;
+    uint64_t size_limit;
+    std::atomic<size_t> hits;
+    std::atomic<size_t> misses;
+    std::mutex evict_mutex;
+};
+
+#endif // COMPILATION_CACHE_H
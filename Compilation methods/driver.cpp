@@ -0,0 +1,331 @@
+#include "driver.h"
+#include "lexer.h"
+#include "parser.h"
+#include "interpreter.h"
+#include "optimizer.h"
+#include "thread_pool.h"
+#include "bytecode.h"
+#include "profiler.h"
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <vector>
+
+// Лексический и синтаксический анализ (и оптимизация), заполняет таблицу символов.
+static CompiledProgram compile_program(const std::string& code, const RunOptions& options,
+    SymbolTable& sym_table, std::ostream& output, ProgramStats* stats = nullptr) {
+    bool silent_mode = options.silent_mode;
+    std::vector<Token> tokens;
+    {
+        PhaseTimer timer(stats, Phase::LEX);
+        Lexer lexer(code);
+        tokens = lexer.tokenize_parallel(options.lexer_threads);
+    }
+    SourceLines lines(code);
+    if (!silent_mode) {
+        output << "Tokens generated successfully (" << tokens.size() << " tokens)\n";
+        output << "Tokens:\n";
+        for (const auto& t : tokens) {
+            output << t.type << " '" << t.value << "' (line " << lines.line(t.offset) << ")\n";
+        }
+    }
+
+    std::vector<OPS> ops_list;
+    {
+        PhaseTimer timer(stats, Phase::PARSE);
+        Parser parser(sym_table);
+        parser.set_output_stream(output);
+        parser.set_silent_mode(silent_mode);
+        ops_list = parser.parse(tokens, lines);
+    }
+
+    if (options.optimize_mode) {
+        PhaseTimer timer(stats, Phase::OPTIMIZE);
+        Optimizer optimizer;
+        optimizer.set_output_stream(output);
+        optimizer.set_silent_mode(silent_mode);
+        ops_list = optimizer.optimize(ops_list);
+    }
+
+    CompiledProgram program;
+    for (const auto& var : sym_table.get_variables()) {
+        program.variables.push_back(var.first);
+    }
+    program.ops = std::move(ops_list);
+    return program;
+}
+
+bool run_program(const std::string& filename, const std::string& code, const RunOptions& options,
+    std::istream& input, std::ostream& output, std::ostream& errors, ProgramStats* stats) {
+    bool silent_mode = options.silent_mode;
+    output << "=== Running test: " << filename << " ===\n";
+    if (!silent_mode) {
+        output << "Code:\n" << code << std::endl;
+    }
+
+    bool success = false;
+    try {
+        SymbolTable sym_table;
+        sym_table.set_output_stream(output);
+        sym_table.set_silent_mode(silent_mode);
+
+        CompiledProgram program;
+        if (options.cache && options.cache->load(code, options.optimize_mode, program)) {
+            for (const auto& name : program.variables) {
+                sym_table.add_variable(name, 0);
+            }
+            if (!silent_mode) {
+                output << "Loaded OPS from cache (" << program.ops.size() << " instructions)\n";
+            }
+        }
+        else {
+            program = compile_program(code, options, sym_table, output, stats);
+            if (options.cache) {
+                options.cache->store(code, options.optimize_mode, program);
+            }
+        }
+        std::vector<OPS>& ops_list = program.ops;
+
+        Interpreter interpreter(sym_table);
+        interpreter.set_io_streams(input, output);
+        interpreter.set_silent_mode(silent_mode);
+
+        if (!silent_mode) {
+            output << "Symbol table before execution:\n";
+            sym_table.print();
+        }
+
+        bool needs_input = false;
+        for (const auto& op_item : ops_list) {
+            if (op_item.operation == "r" || op_item.operation == "array_read" || op_item.operation == "array_read_range") {
+                needs_input = true;
+                break;
+            }
+        }
+        if (needs_input && !silent_mode) {
+            output << "Please provide input for 'read' operations: ";
+        }
+        BytecodeImage image;
+        {
+            PhaseTimer timer(stats, Phase::LOWER);
+            image = compile_bytecode(ops_list, sym_table);
+        }
+        ExecutionProfile profile;
+        if (options.profile_mode) {
+            interpreter.set_profile(&profile);
+        }
+        SamplingProfiler sampler(interpreter.get_current_pc(), image.header().instruction_count, options.sample_rate);
+        if (options.sample_rate) {
+            sampler.start();
+        }
+        {
+            PhaseTimer timer(stats, Phase::EXECUTE);
+            interpreter.execute(image);
+        }
+        sampler.stop();
+        if (options.profile_mode) {
+            print_profile_report(profile, image, code, output);
+        }
+        if (options.sample_rate) {
+            print_sample_report(sampler, image, code, output);
+        }
+
+        if (!silent_mode) {
+            output << "Execution finished. Symbol table final state:\n";
+            sym_table.print();
+        }
+        output << "Test " << filename << " completed successfully\n";
+        success = true;
+    }
+    catch (const std::exception& e) {
+        output.flush();
+        errors << "Error in " << filename << ": " << e.what() << "\n";
+    }
+    if (!silent_mode) {
+        output << std::endl;
+    }
+    return success;
+}
+
+bool run_file(const std::string& filename, const RunOptions& options,
+    std::istream& input, std::ostream& output, std::ostream& errors) {
+    bool collect = options.stats_mode || options.stats_log;
+    ProgramStats stats;
+    if (collect) {
+        stats.begin(filename);
+    }
+    std::string code;
+    {
+        PhaseTimer timer(collect ? &stats : nullptr, Phase::READ);
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            errors << "Error: Cannot open file " << filename << "\n";
+            return false;
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        code = buffer.str();
+    }
+    bool success = run_program(filename, code, options, input, output, errors, collect ? &stats : nullptr);
+    if (collect) {
+        stats.end();
+        stats.success = success;
+        if (options.stats_mode) {
+            stats.print(output);
+        }
+        if (options.stats_log) {
+            options.stats_log->add(stats);
+        }
+    }
+    return success;
+}
+
+int compile_to_file(const std::string& source_file, const std::string& output_file, const RunOptions& options) {
+    std::ifstream source(source_file);
+    if (!source.is_open()) {
+        std::cerr << "Error: Cannot open file " << source_file << std::endl;
+        return 1;
+    }
+    std::stringstream code;
+    code << source.rdbuf();
+    try {
+        SymbolTable sym_table;
+        CompiledProgram program = compile_program(code.str(), options, sym_table, std::cout);
+        BytecodeImage image = compile_bytecode(program.ops, sym_table);
+        image.write_file(output_file);
+        std::cout << "Compiled " << source_file << " to " << output_file << " (" << image.header().instruction_count
+            << " instructions, " << image.header().total_size << " bytes)\n";
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error in " << source_file << ": " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+int run_bytecode_file(const std::string& bytecode_file, const RunOptions& options) {
+    try {
+        BytecodeImage image = BytecodeImage::map_file(bytecode_file);
+        SymbolTable sym_table;
+        sym_table.set_silent_mode(options.silent_mode);
+        Interpreter interpreter(sym_table);
+        interpreter.set_silent_mode(options.silent_mode);
+        ExecutionProfile profile;
+        if (options.profile_mode) {
+            interpreter.set_profile(&profile);
+        }
+        SamplingProfiler sampler(interpreter.get_current_pc(), image.header().instruction_count, options.sample_rate);
+        if (options.sample_rate) {
+            sampler.start();
+        }
+        interpreter.execute(image);
+        sampler.stop();
+        if (options.profile_mode) {
+            print_profile_report(profile, image, "", std::cout);
+        }
+        if (options.sample_rate) {
+            print_sample_report(sampler, image, "", std::cout);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cout.flush();
+        std::cerr << "Error in " << bytecode_file << ": " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+int disassemble_file(const std::string& bytecode_file) {
+    try {
+        BytecodeImage image = BytecodeImage::map_file(bytecode_file);
+        disassemble(image, std::cout);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error in " << bytecode_file << ": " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+void print_cache_stats(const CompilationCache& cache) {
+    std::cout << "=== Cache: " << cache.get_hits() << " hits, " << cache.get_misses() << " misses ===\n";
+}
+
+struct BatchJob {
+    std::string program_file;
+    std::string input_file;
+    std::ostringstream output;
+    std::ostringstream errors;
+    bool success = false;
+    std::promise<void> done;
+};
+
+static void run_batch_job(BatchJob& job, const RunOptions& options) {
+    std::ifstream input_file;
+    std::istringstream no_input;
+    std::istream* input = &no_input;
+    if (!job.input_file.empty()) {
+        input_file.open(job.input_file);
+        if (!input_file.is_open()) {
+            job.errors << "Error: Cannot open input file " << job.input_file << "\n";
+            return;
+        }
+        input = &input_file;
+    }
+    job.success = run_file(job.program_file, options, *input, job.output, job.errors);
+}
+
+int run_batch(const std::string& list_file, size_t thread_count, const RunOptions& options) {
+    std::ifstream list(list_file);
+    if (!list.is_open()) {
+        std::cerr << "Error: Cannot open file " << list_file << std::endl;
+        return 1;
+    }
+    std::vector<std::unique_ptr<BatchJob>> jobs;
+    std::string line;
+    while (std::getline(list, line)) {
+        std::istringstream fields(line);
+        auto job = std::make_unique<BatchJob>();
+        if (!(fields >> job->program_file)) continue;
+        fields >> job->input_file;
+        jobs.push_back(std::move(job));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t failed = 0;
+    {
+        ThreadPool pool(thread_count);
+        for (auto& job : jobs) {
+            BatchJob* job_ptr = job.get();
+            pool.submit([job_ptr, &options] {
+                try {
+                    run_batch_job(*job_ptr, options);
+                }
+                catch (const std::exception& e) {
+                    job_ptr->errors << "Error in " << job_ptr->program_file << ": " << e.what() << "\n";
+                }
+                catch (...) {
+                    // Исключение не должно уйти из рабочего потока: done не был бы выставлен.
+                    job_ptr->errors << "Error in " << job_ptr->program_file << ": unknown error\n";
+                }
+                job_ptr->done.set_value();
+            });
+        }
+        // Вывод печатается в порядке списка, по мере готовности очередной программы.
+        for (auto& job : jobs) {
+            job->done.get_future().wait();
+            std::cout << job->output.str();
+            std::cerr << job->errors.str();
+            if (!job->success) ++failed;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "=== Batch completed: " << jobs.size() << " programs, " << failed << " failed, "
+        << seconds << " s, " << (seconds > 0 ? jobs.size() / seconds : 0.0) << " programs/s ===\n";
+    if (options.cache) {
+        print_cache_stats(*options.cache);
+    }
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,45 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include "compilation_cache.h"
+#include "stats.h"
+#include <iostream>
+#include <string>
+
+struct RunOptions {
+    bool silent_mode;
+    bool optimize_mode;
+    CompilationCache* cache; // nullptr — кэш отключён
+    bool stats_mode = false;        // печатать статистику после вывода программы
+    StatsLog* stats_log = nullptr;  // nullptr — статистика не сохраняется
+    bool profile_mode = false;      // печатать профиль по строкам после выполнения
+    unsigned sample_rate = 0;       // частота выборок SamplingProfiler, Гц (0 — выключен)
+    size_t lexer_threads = 1;       // потоки Lexer::tokenize_parallel для больших файлов
+};
+
+// Компилирует (или берёт из кэша) и выполняет одну программу. Значения для read берутся из input,
+// весь вывод (включая подробный режим) идёт в output, ошибки — в errors.
+bool run_program(const std::string& filename, const std::string& code, const RunOptions& options,
+    std::istream& input, std::ostream& output, std::ostream& errors, ProgramStats* stats = nullptr);
+
+// Читает файл и выполняет его через run_program. Если включена статистика, замеряет
+// фазы (включая чтение), печатает отчёт в output и добавляет его в options.stats_log.
+bool run_file(const std::string& filename, const RunOptions& options,
+    std::istream& input, std::ostream& output, std::ostream& errors);
+
+// Пакетный режим: каждая строка list_file — "программа [файл_ввода]". Программы
+// компилируются и выполняются параллельно, вывод печатается в порядке списка.
+int run_batch(const std::string& list_file, size_t thread_count, const RunOptions& options);
+
+// Компилирует программу в файл байткода (см. bytecode.h).
+int compile_to_file(const std::string& source_file, const std::string& output_file, const RunOptions& options);
+
+// Выполняет файл байткода, отображая его в память; лексер и парсер не используются.
+int run_bytecode_file(const std::string& bytecode_file, const RunOptions& options);
+
+// Печатает инструкции файла байткода в виде ОПС (см. disassemble).
+int disassemble_file(const std::string& bytecode_file);
+
+void print_cache_stats(const CompilationCache& cache);
+
+#endif // DRIVER_H
@@ -1,11 +1,15 @@
 #include "error.h"
 #include <sstream>
 
-Error::Error(const std::string& type, const std::string& symbol, int line, int pos)
-    : type(type), symbol(symbol), line(line), pos(pos) {}
-
-std::string Error::message() const {
+static std::string format_error(const std::string& type, const std::string& symbol, int line, int pos) {
     std::stringstream ss;
     ss << type << " at line " << line << ", position " << pos << ": invalid symbol '" << symbol << "'";
     return ss.str();
+}
+
+Error::Error(const std::string& type, const std::string& symbol, int line, int pos)
+    : std::runtime_error(format_error(type, symbol, line, pos)), type(type), symbol(symbol), line(line), pos(pos) {}
+
+std::string Error::message() const {
+    return what();
 }
\ No newline at end of file
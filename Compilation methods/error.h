@@ -1,9 +1,12 @@
 #ifndef ERROR_H
 #define ERROR_H
 
+#include <stdexcept>
 #include <string>
 
-class Error {
+// Ошибка во входном тексте. Наследует std::runtime_error, чтобы её ловили те же
+// обработчики, что и остальные ошибки компиляции и выполнения.
+class Error : public std::runtime_error {
 public:
     Error(const std::string& type, const std::string& symbol, int line, int pos);
     std::string message() const;
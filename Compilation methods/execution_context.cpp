@@ -0,0 +1,697 @@
+#include "execution_context.h"
+#include "bulk_ops.h"
+#include "stats.h"
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+ExecutionContext::ExecutionContext(const BytecodeImage& image)
+    : image(image), trace(nullptr), profile(nullptr), own_pc(static_cast<size_t>(-1)), published_pc(&own_pc),
+      executed_count(0), jumps_count(0), resume_pc(0), waiting_for_input(false), pending_input(0), has_pending_input(false) {
+    const size_t symbol_count = image.header().symbol_count;
+    names.resize(symbol_count);
+    for (uint32_t s = 0; s < symbol_count; ++s) {
+        names[s] = image.get_symbol_name(s);
+        symbol_index.emplace(names[s], s);
+    }
+    stack.reserve(64);
+    reset();
+}
+
+void ExecutionContext::reset() {
+    const size_t symbol_count = names.size();
+    variables.assign(symbol_count, 0);
+    arrays.assign(symbol_count, std::vector<int>());
+    is_array.assign(symbol_count, 0);
+    is_variable.assign(symbol_count, 0);
+    for (size_t s = 0; s < symbol_count; ++s) {
+        is_variable[s] = image.symbols()[s].kind == SymbolKind::VARIABLE;
+    }
+    stack.clear();
+    waiting_for_input = false;
+    has_pending_input = false;
+}
+
+void ExecutionContext::set_input(ReadCallback callback) {
+    input = std::move(callback);
+}
+
+void ExecutionContext::set_output(WriteCallback callback) {
+    output = std::move(callback);
+}
+
+void ExecutionContext::set_trace(std::ostream* stream) {
+    trace = stream;
+}
+
+void ExecutionContext::set_profile(ExecutionProfile* profile) {
+    this->profile = profile;
+}
+
+void ExecutionContext::set_pc_publisher(std::atomic<size_t>* pc) {
+    published_pc = pc ? pc : &own_pc;
+}
+
+size_t ExecutionContext::get_symbol_count() const {
+    return names.size();
+}
+
+const std::string& ExecutionContext::get_symbol_name(size_t symbol) const {
+    return names[symbol];
+}
+
+bool ExecutionContext::has_variable(size_t symbol) const {
+    return is_variable[symbol] != 0;
+}
+
+bool ExecutionContext::has_array(size_t symbol) const {
+    return is_array[symbol] != 0;
+}
+
+int& ExecutionContext::variable(size_t symbol) {
+    return variables[symbol];
+}
+
+std::vector<int>& ExecutionContext::array(size_t symbol) {
+    return arrays[symbol];
+}
+
+void ExecutionContext::define_array(size_t symbol, const std::vector<int>& values) {
+    arrays[symbol] = values;
+    is_array[symbol] = 1;
+}
+
+size_t ExecutionContext::find_symbol(const std::string& name) const {
+    auto it = symbol_index.find(name);
+    return it == symbol_index.end() ? names.size() : it->second;
+}
+
+int ExecutionContext::get_variable(const std::string& name) const {
+    size_t s = find_symbol(name);
+    if (s == names.size() || !is_variable[s]) throw std::runtime_error("Variable '" + name + "' not found");
+    return variables[s];
+}
+
+void ExecutionContext::set_variable(const std::string& name, int value) {
+    size_t s = find_symbol(name);
+    if (s == names.size() || !is_variable[s]) throw std::runtime_error("Variable '" + name + "' not found");
+    variables[s] = value;
+}
+
+const std::vector<int>& ExecutionContext::get_array(const std::string& name) const {
+    size_t s = find_symbol(name);
+    if (s == names.size() || !is_array[s]) throw std::runtime_error("Array '" + name + "' not found");
+    return arrays[s];
+}
+
+size_t ExecutionContext::get_executed_count() const {
+    return executed_count;
+}
+
+size_t ExecutionContext::get_jumps_count() const {
+    return jumps_count;
+}
+
+// Первый индекс из [start, end), выходящий за границы массива размера size (или end, если таких нет).
+static int first_out_of_bounds(int start, int end, size_t size) {
+    if (start >= end) return end;
+    if (start < 0) return start;
+    if (end > static_cast<int>(size)) return std::max(start, static_cast<int>(size));
+    return end;
+}
+
+void ExecutionContext::run() {
+    begin_execution();
+    execute_from(0, false);
+}
+
+ExecutionStatus ExecutionContext::start() {
+    begin_execution();
+    return execute_from(0, true);
+}
+
+ExecutionStatus ExecutionContext::resume(int value) {
+    if (!waiting_for_input) {
+        throw std::runtime_error("Program is not waiting for input");
+    }
+    waiting_for_input = false;
+    pending_input = value;
+    has_pending_input = true;
+    return execute_from(resume_pc, true);
+}
+
+bool ExecutionContext::is_waiting_for_input() const {
+    return waiting_for_input;
+}
+
+const std::string& ExecutionContext::get_input_target() const {
+    return input_target;
+}
+
+void ExecutionContext::begin_execution() {
+    stack.clear();
+    executed_count = 0;
+    jumps_count = 0;
+    waiting_for_input = false;
+    has_pending_input = false;
+    if (profile) profile->reset(image.header().instruction_count);
+}
+
+ExecutionStatus ExecutionContext::execute_from(size_t start_pc, bool can_suspend) {
+    const Opcode* opcodes = image.opcodes();
+    const int32_t* operands = image.operands();
+    const int32_t* constants = image.constants();
+    const size_t code_size = image.header().instruction_count;
+
+    auto assign_variable = [&](int32_t s, int value) {
+        if (!is_variable[s]) throw std::runtime_error("Variable '" + names[s] + "' not found");
+        variables[s] = value;
+    };
+    auto checked_array = [&](int32_t s) -> std::vector<int>& {
+        if (!is_array[s]) throw std::runtime_error("Array '" + names[s] + "' not found");
+        return arrays[s];
+    };
+    auto set_array_element = [&](int32_t s, int index, int value) {
+        std::vector<int>& arr = checked_array(s);
+        if (index < 0 || index >= static_cast<int>(arr.size())) {
+            throw std::runtime_error("Array index out of bounds for '" + names[s] + "': " + std::to_string(index));
+        }
+        arr[index] = value;
+    };
+    // false — значения нет и выполнение приостанавливается (start/resume без функции ввода).
+    auto take_input = [&](const std::string& target, const std::string& what, int& value) {
+        if (input) {
+            if (input(target, value)) return true;
+        }
+        else if (has_pending_input) {
+            value = pending_input;
+            has_pending_input = false;
+            return true;
+        }
+        else if (can_suspend) {
+            input_target = target;
+            return false;
+        }
+        throw std::runtime_error("Invalid input for " + what + " operation");
+    };
+    auto write_value = [&](int value) {
+        if (output) output(value);
+    };
+
+    size_t pc = start_pc;
+    size_t executed = 0;
+    size_t jumps = 0;
+
+    // Профилирование: такты между началами соседних инструкций относятся к первой из них.
+    ExecutionProfile* const profile_data = profile;
+    size_t profiled_pc = code_size;
+    uint64_t profiled_start = 0;
+    auto finish = [&]() {
+        published_pc->store(static_cast<size_t>(-1), std::memory_order_relaxed);
+        if (profile_data && profiled_pc < code_size) {
+            profile_data->cycles[profiled_pc] += read_cycle_counter() - profiled_start;
+        }
+        executed_count += executed;
+        jumps_count += jumps;
+        STATS_ADD(INSTRUCTIONS, executed);
+        STATS_ADD(JUMPS_TAKEN, jumps);
+    };
+    // Инструкция чтения не изменила состояние и будет выполнена заново при resume.
+    auto suspend = [&]() {
+        --executed;
+        finish();
+        resume_pc = pc;
+        waiting_for_input = true;
+        return ExecutionStatus::NEEDS_INPUT;
+    };
+
+    try {
+        while (pc < code_size) {
+            const Opcode opcode = opcodes[pc];
+            const int32_t operand = operands[pc];
+            ++executed;
+            published_pc->store(pc, std::memory_order_relaxed);
+            if (profile_data) {
+                uint64_t now = read_cycle_counter();
+                if (profiled_pc < code_size) profile_data->cycles[profiled_pc] += now - profiled_start;
+                ++profile_data->counts[pc];
+                profiled_pc = pc;
+                profiled_start = now;
+            }
+            if (trace) {
+                std::string text = image.get_operand_text(pc);
+                *trace << "Executing op " << pc << ": " << get_opcode_name(opcode) << (text.empty() ? "" : " " + text) << "\n";
+            }
+
+            switch (opcode) {
+            case Opcode::READ: {
+                int value;
+                if (!take_input(names[operand], "read", value)) return suspend();
+                assign_variable(operand, value);
+                if (trace) {
+                    *trace << "Read " << value << " into " << names[operand] << "\n";
+                }
+                break;
+            }
+            case Opcode::PUSH_VAR: {
+                if (is_variable[operand]) {
+                    stack.push_back(variables[operand]);
+                    if (trace) *trace << "Pushed variable " << names[operand] << ": " << variables[operand] << "\n";
+                }
+                else if (is_array[operand]) {
+                    throw std::runtime_error("Operand " + names[operand] + " is likely an array used as a variable, or not found. Details: Variable '" + names[operand] + "' not found");
+                }
+                else {
+                    try {
+                        (void)std::stoi(names[operand]);
+                    }
+                    catch (const std::out_of_range&) {
+                        throw std::runtime_error("Number out of range for push: " + names[operand]);
+                    }
+                    catch (const std::invalid_argument&) {
+                    }
+                    throw std::runtime_error("Invalid number for push: " + names[operand]);
+                }
+                break;
+            }
+            case Opcode::PUSH_CONST: {
+                int value = constants[operand];
+                stack.push_back(value);
+                if (trace) *trace << "Pushed number: " << value << "\n";
+                break;
+            }
+            case Opcode::ADD: {
+                if (stack.size() < 2) throw std::runtime_error("Stack underflow for + operation at pc " + std::to_string(pc));
+                int right = stack.back(); stack.pop_back();
+                int left = stack.back(); stack.pop_back();
+                stack.push_back(left + right);
+                if (trace) {
+                    *trace << "Computed " << left << " + " << right << " = " << (left + right) << "\n";
+                }
+                break;
+            }
+            case Opcode::SUB: {
+                if (stack.size() < 2) throw std::runtime_error("Stack underflow for - operation at pc " + std::to_string(pc));
+                int right = stack.back(); stack.pop_back();
+                int left = stack.back(); stack.pop_back();
+                stack.push_back(left - right);
+                if (trace) *trace << "Computed " << left << " - " << right << " = " << (left - right) << "\n";
+                break;
+            }
+            case Opcode::MUL: {
+                if (stack.size() < 2) throw std::runtime_error("Stack underflow for * operation at pc " + std::to_string(pc));
+                int right = stack.back(); stack.pop_back();
+                int left = stack.back(); stack.pop_back();
+                stack.push_back(left * right);
+                if (trace) *trace << "Computed " << left << " * " << right << " = " << (left * right) << "\n";
+                break;
+            }
+            case Opcode::DIV: {
+                if (stack.size() < 2) throw std::runtime_error("Stack underflow for / operation at pc " + std::to_string(pc));
+                int right = stack.back(); stack.pop_back();
+                int left = stack.back(); stack.pop_back();
+                if (right == 0) throw std::runtime_error("Division by zero at pc " + std::to_string(pc));
+                stack.push_back(left / right);
+                if (trace) *trace << "Computed " << left << " / " << right << " = " << (left / right) << "\n";
+                break;
+            }
+            case Opcode::SHL: {
+                if (stack.empty()) throw std::runtime_error("Stack underflow for shl operation at pc " + std::to_string(pc));
+                int val = stack.back();
+                // Сдвиг беззнакового значения: переполнение даёт то же, что и умножение.
+                stack.back() = static_cast<int>(static_cast<unsigned>(val) << constants[operand]);
+                if (trace) *trace << "Computed " << val << " << " << constants[operand] << " = " << stack.back() << "\n";
+                break;
+            }
+            case Opcode::DIV_CONST: {
+                if (stack.empty()) throw std::runtime_error("Stack underflow for div_const operation at pc " + std::to_string(pc));
+                int val = stack.back();
+                stack.back() = divide_by_magic(val, constants[operand + 1], constants[operand + 2]);
+                if (trace) *trace << "Computed " << val << " / " << constants[operand] << " = " << stack.back() << "\n";
+                break;
+            }
+            case Opcode::NEG: {
+                if (stack.empty()) throw std::runtime_error("Stack underflow for ~ operation at pc " + std::to_string(pc));
+                int val = stack.back(); stack.pop_back();
+                stack.push_back(-val);
+                if (trace) *trace << "Computed ~" << val << " = " << (-val) << "\n";
+                break;
+            }
+            case Opcode::GT: {
+                if (stack.size() < 2) throw std::runtime_error("Stack underflow for > operation at pc " + std::to_string(pc));
+                int right = stack.back(); stack.pop_back();
+                int left = stack.back(); stack.pop_back();
+                stack.push_back(left > right ? 1 : 0);
+                if (trace) *trace << "Computed " << left << " > " << right << " = " << (left > right ? 1 : 0) << "\n";
+                break;
+            }
+            case Opcode::LT: {
+                if (stack.size() < 2) throw std::runtime_error("Stack underflow for < operation at pc " + std::to_string(pc));
+                int right = stack.back(); stack.pop_back();
+                int left = stack.back(); stack.pop_back();
+                stack.push_back(left < right ? 1 : 0);
+                if (trace) *trace << "Computed " << left << " < " << right << " = " << (left < right ? 1 : 0) << "\n";
+                break;
+            }
+            case Opcode::EQ: {
+                if (stack.size() < 2) throw std::runtime_error("Stack underflow for == operation at pc " + std::to_string(pc));
+                int right = stack.back(); stack.pop_back();
+                int left = stack.back(); stack.pop_back();
+                stack.push_back(left == right ? 1 : 0);
+                if (trace) *trace << "Computed " << left << " == " << right << " = " << (left == right ? 1 : 0) << "\n";
+                break;
+            }
+            case Opcode::AND: {
+                if (stack.size() < 2) throw std::runtime_error("Stack underflow for & operation at pc " + std::to_string(pc));
+                int right = stack.back(); stack.pop_back();
+                int left = stack.back(); stack.pop_back();
+                stack.push_back((left != 0) && (right != 0) ? 1 : 0);
+                if (trace) *trace << "Computed " << left << " & " << right << " = " << ((left != 0) && (right != 0) ? 1 : 0) << "\n";
+                break;
+            }
+            case Opcode::OR: {
+                if (stack.size() < 2) throw std::runtime_error("Stack underflow for | operation at pc " + std::to_string(pc));
+                int right = stack.back(); stack.pop_back();
+                int left = stack.back(); stack.pop_back();
+                stack.push_back((left != 0) || (right != 0) ? 1 : 0);
+                if (trace) *trace << "Computed " << left << " | " << right << " = " << ((left != 0) || (right != 0) ? 1 : 0) << "\n";
+                break;
+            }
+            case Opcode::NOT: {
+                if (stack.empty()) throw std::runtime_error("Stack underflow for ! operation at pc " + std::to_string(pc));
+                int val = stack.back(); stack.pop_back();
+                stack.push_back(val == 0 ? 1 : 0);
+                if (trace) *trace << "Computed !" << val << " = " << (val == 0 ? 1 : 0) << "\n";
+                break;
+            }
+            case Opcode::JF: {
+                if (stack.empty()) throw std::runtime_error("Stack underflow for jf condition at pc " + std::to_string(pc));
+                int condition = stack.back(); stack.pop_back();
+                if (trace) {
+                    *trace << "jf condition: " << condition << ", target: " << operand << "\n";
+                }
+                if (condition == 0) {
+                    ++jumps;
+                    pc = static_cast<size_t>(operand);
+                    if (trace) {
+                        *trace << "Jumping to " << pc << "\n";
+                    }
+                    continue;
+                }
+                break;
+            }
+            case Opcode::JT: {
+                if (stack.empty()) throw std::runtime_error("Stack underflow for jt condition at pc " + std::to_string(pc));
+                int condition = stack.back(); stack.pop_back();
+                if (trace) {
+                    *trace << "jt condition: " << condition << ", target: " << operand << "\n";
+                }
+                if (condition != 0) {
+                    ++jumps;
+                    pc = static_cast<size_t>(operand);
+                    if (trace) {
+                        *trace << "Jumping to " << pc << "\n";
+                    }
+                    continue;
+                }
+                break;
+            }
+            case Opcode::J: {
+                ++jumps;
+                pc = static_cast<size_t>(operand);
+                if (trace) {
+                    *trace << "Jumping to " << pc << "\n";
+                }
+                continue;
+            }
+            case Opcode::ASSIGN: {
+                if (stack.empty()) throw std::runtime_error("Stack underflow for = operation (value) at pc " + std::to_string(pc));
+                int value = stack.back(); stack.pop_back();
+                assign_variable(operand, value);
+                if (trace) {
+                    *trace << "Set " << names[operand] << " = " << value << "\n";
+                }
+                break;
+            }
+            case Opcode::ALLOC_ARRAY: {
+                if (stack.empty()) throw std::runtime_error("Stack underflow for alloc_array size at pc " + std::to_string(pc));
+                int size = stack.back(); stack.pop_back();
+                if (size <= 0) throw std::runtime_error("Invalid array size: " + std::to_string(size) + " for array " + names[operand] + " at pc " + std::to_string(pc));
+                if (is_variable[operand] || is_array[operand]) {
+                    throw std::runtime_error("Variable or array '" + names[operand] + "' already exists");
+                }
+                arrays[operand].assign(size, 0);
+                is_array[operand] = 1;
+                if (trace) {
+                    *trace << "Added array: " << names[operand] << " with size " << size << "\n";
+                    *trace << "Allocated array " << names[operand] << " of size " << size << "\n";
+                }
+                break;
+            }
+            case Opcode::INIT_ARRAY: {
+                int num_initializers = constants[operand];
+                int32_t array = constants[operand + 1];
+                if (stack.size() < static_cast<size_t>(num_initializers)) {
+                    throw std::runtime_error("Stack underflow during array initialization, expected " + std::to_string(num_initializers) + " values, got " + std::to_string(stack.size()) + " at pc " + std::to_string(pc));
+                }
+
+                std::vector<int> initial_values(stack.end() - num_initializers, stack.end());
+                stack.resize(stack.size() - num_initializers);
+
+                if (array < 0) {
+                    throw std::runtime_error("Could not find corresponding alloc_array for init_array of (operand was " + std::to_string(num_initializers) + ", num_initializers: " + std::to_string(num_initializers) + ") at pc " + std::to_string(pc));
+                }
+
+                std::vector<int>& arr = checked_array(array);
+                if (num_initializers > static_cast<int>(arr.size())) {
+                    throw std::runtime_error("Too many initializers (" + std::to_string(num_initializers) + ") for array " + names[array] + " of size " + std::to_string(arr.size()) + " at pc " + std::to_string(pc));
+                }
+                for (int i = 0; i < num_initializers; ++i) {
+                    arr[i] = initial_values[i];
+                }
+                if (trace) {
+                    *trace << "Initialized array " << names[array] << " with " << num_initializers << " values\n";
+                }
+                break;
+            }
+            case Opcode::ARRAY_READ: {
+                if (stack.empty()) throw std::runtime_error("Stack underflow for array_read index at pc " + std::to_string(pc));
+                int index = stack.back();
+                int value;
+                if (!take_input(names[operand] + "[" + std::to_string(index) + "]", "array_read", value)) return suspend();
+                stack.pop_back();
+                set_array_element(operand, index, value);
+                if (trace) {
+                    *trace << "Read " << value << " into " << names[operand] << "[" << index << "]\n";
+                }
+                break;
+            }
+            case Opcode::ARRAY_GET: {
+                if (stack.empty()) throw std::runtime_error("Stack underflow for array_get index at pc " + std::to_string(pc));
+                int index = stack.back(); stack.pop_back();
+                const std::vector<int>& arr = checked_array(operand);
+                if (index < 0 || index >= static_cast<int>(arr.size())) {
+                    throw std::runtime_error("Array index out of bounds: " + std::to_string(index) + " for array " + names[operand] + " of size " + std::to_string(arr.size()) + " at pc " + std::to_string(pc));
+                }
+                stack.push_back(arr[index]);
+                if (trace) {
+                    *trace << "Pushed " << names[operand] << "[" << index << "] = " << arr[index] << "\n";
+                }
+                break;
+            }
+            case Opcode::ARRAY_SET: {
+                if (stack.size() < 2) throw std::runtime_error("Stack underflow for array_set operation (value or index missing) at pc " + std::to_string(pc));
+                int value = stack.back(); stack.pop_back();
+                int index = stack.back(); stack.pop_back();
+                set_array_element(operand, index, value);
+                if (trace) {
+                    *trace << "Set " << names[operand] << "[" << index << "] = " << value << "\n";
+                }
+                break;
+            }
+            case Opcode::ARRAY_FILL: {
+                if (stack.empty()) throw std::runtime_error("Stack underflow for array_fill value at pc " + std::to_string(pc));
+                int value = stack.back(); stack.pop_back();
+                std::vector<int>& arr = checked_array(operand);
+                bulk_fill(arr.data(), arr.size(), value);
+                if (trace) {
+                    *trace << "Filled " << names[operand] << " with " << value << "\n";
+                }
+                break;
+            }
+            case Opcode::ARRAY_ADD:
+            case Opcode::ARRAY_SUB:
+            case Opcode::ARRAY_MUL: {
+                if (stack.empty()) throw std::runtime_error(std::string("Stack underflow for ") + get_opcode_name(opcode) + " value at pc " + std::to_string(pc));
+                int value = stack.back(); stack.pop_back();
+                std::vector<int>& arr = checked_array(operand);
+                if (opcode == Opcode::ARRAY_ADD) bulk_add_scalar(arr.data(), arr.size(), value);
+                else if (opcode == Opcode::ARRAY_SUB) bulk_sub_scalar(arr.data(), arr.size(), value);
+                else bulk_mul_scalar(arr.data(), arr.size(), value);
+                if (trace) {
+                    *trace << "Computed " << get_opcode_name(opcode) << " " << names[operand] << ", " << value << "\n";
+                }
+                break;
+            }
+            case Opcode::ARRAY_COPY:
+            case Opcode::ARRAY_ADD_ARRAY:
+            case Opcode::ARRAY_SUB_ARRAY:
+            case Opcode::ARRAY_MUL_ARRAY: {
+                int32_t dst_id = constants[operand];
+                int32_t src_id = constants[operand + 1];
+                std::vector<int>& dst = checked_array(dst_id);
+                const std::vector<int>& src = checked_array(src_id);
+                if (dst.size() != src.size()) {
+                    throw std::runtime_error(std::string("Array size mismatch for ") + get_opcode_name(opcode) + ": " + names[dst_id] + " of size " + std::to_string(dst.size())
+                        + ", " + names[src_id] + " of size " + std::to_string(src.size()) + " at pc " + std::to_string(pc));
+                }
+                if (opcode == Opcode::ARRAY_COPY) bulk_copy(dst.data(), src.data(), dst.size());
+                else if (opcode == Opcode::ARRAY_ADD_ARRAY) bulk_add_array(dst.data(), src.data(), dst.size());
+                else if (opcode == Opcode::ARRAY_SUB_ARRAY) bulk_sub_array(dst.data(), src.data(), dst.size());
+                else bulk_mul_array(dst.data(), src.data(), dst.size());
+                if (trace) {
+                    *trace << "Computed " << get_opcode_name(opcode) << " " << names[dst_id] << ", " << names[src_id] << "\n";
+                }
+                break;
+            }
+            case Opcode::ARRAY_SORT: {
+                std::vector<int>& arr = checked_array(operand);
+                bulk_sort(arr.data(), arr.size());
+                if (trace) {
+                    *trace << "Sorted " << names[operand] << "\n";
+                }
+                break;
+            }
+            case Opcode::ARRAY_SUM:
+            case Opcode::ARRAY_MIN:
+            case Opcode::ARRAY_MAX: {
+                const std::vector<int>& arr = checked_array(operand);
+                int value;
+                if (opcode == Opcode::ARRAY_SUM) value = bulk_sum(arr.data(), arr.size());
+                else if (opcode == Opcode::ARRAY_MIN) value = bulk_min(arr.data(), arr.size());
+                else value = bulk_max(arr.data(), arr.size());
+                stack.push_back(value);
+                if (trace) {
+                    *trace << "Pushed " << get_opcode_name(opcode) << "(" << names[operand] << ") = " << value << "\n";
+                }
+                break;
+            }
+            case Opcode::ARRAY_FILL_RANGE: {
+                if (stack.size() < 3) throw std::runtime_error("Stack underflow for array_fill_range at pc " + std::to_string(pc));
+                int value = stack.back(); stack.pop_back();
+                int end = stack.back(); stack.pop_back();
+                int start = stack.back(); stack.pop_back();
+                std::vector<int>& arr = checked_array(operand);
+                int bad = first_out_of_bounds(start, end, arr.size());
+                if (start < bad) bulk_fill(arr.data() + start, static_cast<size_t>(bad - start), value);
+                if (bad < end) set_array_element(operand, bad, value); // та же ошибка, что и у исходного цикла
+                stack.push_back(start < end ? end : start);
+                if (trace) {
+                    *trace << "Filled " << names[operand] << "[" << start << ".." << end << ") with " << value << "\n";
+                }
+                break;
+            }
+            case Opcode::ARRAY_COPY_RANGE: {
+                if (stack.size() < 2) throw std::runtime_error("Stack underflow for array_copy_range at pc " + std::to_string(pc));
+                int end = stack.back(); stack.pop_back();
+                int start = stack.back(); stack.pop_back();
+                int32_t dst_id = constants[operand];
+                int32_t src_id = constants[operand + 1];
+                std::vector<int>& dst = checked_array(dst_id);
+                const std::vector<int>& src = checked_array(src_id);
+                int bad_src = first_out_of_bounds(start, end, src.size());
+                int bad = std::min(bad_src, first_out_of_bounds(start, end, dst.size()));
+                if (start < bad) bulk_copy(dst.data() + start, src.data() + start, static_cast<size_t>(bad - start));
+                if (bad < end) {
+                    // Исходный цикл сначала читает src[k], затем пишет dst[k].
+                    if (bad == bad_src) {
+                        throw std::runtime_error("Array index out of bounds: " + std::to_string(bad) + " for array " + names[src_id] + " of size " + std::to_string(src.size()) + " at pc " + std::to_string(pc));
+                    }
+                    set_array_element(dst_id, bad, src[bad]);
+                }
+                stack.push_back(start < end ? end : start);
+                if (trace) {
+                    *trace << "Copied " << names[src_id] << "[" << start << ".." << end << ") into " << names[dst_id] << "\n";
+                }
+                break;
+            }
+            case Opcode::ARRAY_READ_RANGE: {
+                if (stack.size() < 2) throw std::runtime_error("Stack underflow for array_read_range at pc " + std::to_string(pc));
+                // Границы остаются на стеке до конца чтения: при приостановке начало
+                // диапазона сдвигается на первый непрочитанный индекс.
+                const size_t top = stack.size();
+                int end = stack[top - 1];
+                int start = stack[top - 2];
+                for (int index = start; index < end; ++index) {
+                    int value;
+                    if (!take_input(names[operand] + "[" + std::to_string(index) + "]", "array_read", value)) {
+                        stack[top - 2] = index;
+                        return suspend();
+                    }
+                    set_array_element(operand, index, value);
+                    if (trace) {
+                        *trace << "Read " << value << " into " << names[operand] << "[" << index << "]\n";
+                    }
+                }
+                stack.resize(top - 2);
+                stack.push_back(start < end ? end : start);
+                break;
+            }
+            case Opcode::ARRAY_PRINT_RANGE: {
+                if (stack.size() < 2) throw std::runtime_error("Stack underflow for array_print_range at pc " + std::to_string(pc));
+                int end = stack.back(); stack.pop_back();
+                int start = stack.back(); stack.pop_back();
+                const std::vector<int>& arr = checked_array(operand);
+                int bad = first_out_of_bounds(start, end, arr.size());
+                for (int index = start; index < bad; ++index) {
+                    write_value(arr[index]);
+                }
+                if (bad < end) {
+                    throw std::runtime_error("Array index out of bounds: " + std::to_string(bad) + " for array " + names[operand] + " of size " + std::to_string(arr.size()) + " at pc " + std::to_string(pc));
+                }
+                stack.push_back(start < end ? end : start);
+                break;
+            }
+            case Opcode::ARRAY_GET_UNCHECKED: {
+                // Индекс доказан оптимизатором, проверка границ не нужна.
+                if (stack.empty()) throw std::runtime_error("Stack underflow for array_get index at pc " + std::to_string(pc));
+                int index = stack.back(); stack.pop_back();
+                const std::vector<int>& arr = checked_array(operand);
+                assert(static_cast<unsigned>(index) < arr.size() && "bounds check eliminated for an unproven index");
+                stack.push_back(arr[index]);
+                if (trace) {
+                    *trace << "Pushed " << names[operand] << "[" << index << "] = " << arr[index] << "\n";
+                }
+                break;
+            }
+            case Opcode::ARRAY_SET_UNCHECKED: {
+                if (stack.size() < 2) throw std::runtime_error("Stack underflow for array_set operation (value or index missing) at pc " + std::to_string(pc));
+                int value = stack.back(); stack.pop_back();
+                int index = stack.back(); stack.pop_back();
+                std::vector<int>& arr = checked_array(operand);
+                assert(static_cast<unsigned>(index) < arr.size() && "bounds check eliminated for an unproven index");
+                arr[index] = value;
+                if (trace) {
+                    *trace << "Set " << names[operand] << "[" << index << "] = " << value << "\n";
+                }
+                break;
+            }
+            case Opcode::WRITE: {
+                if (stack.empty()) throw std::runtime_error("Stack is empty for 'w' operation at pc " + std::to_string(pc));
+                int value = stack.back(); stack.pop_back();
+                write_value(value);
+                break;
+            }
+            default:
+                throw std::runtime_error(std::string("Unknown operation: ") + get_opcode_name(opcode) + " at pc " + std::to_string(pc));
+            }
+            pc++;
+        }
+    }
+    catch (...) {
+        finish();
+        throw;
+    }
+    finish();
+    return ExecutionStatus::FINISHED;
+}
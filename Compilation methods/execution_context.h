@@ -0,0 +1,97 @@
+#ifndef EXECUTION_CONTEXT_H
+#define EXECUTION_CONTEXT_H
+
+#include "bytecode.h"
+#include "profiler.h"
+#include <atomic>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Ввод для read: target — "x" или "a[3]"; false — значения нет (ошибка "Invalid input").
+using ReadCallback = std::function<bool(const std::string& target, int& value)>;
+// Вывод print.
+using WriteCallback = std::function<void(int value)>;
+
+enum class ExecutionStatus {
+    FINISHED,
+    NEEDS_INPUT  // выполнение приостановлено на read, продолжается resume
+};
+
+// Состояние одного выполнения байткода: переменные и массивы (по индексам символов
+// образа), стек и ввод-вывод. Образ только читается, поэтому один образ можно
+// выполнять одновременно в нескольких контекстах из разных потоков; сам контекст
+// используется одним потоком. Контекст можно выполнять многократно, вызывая reset.
+class ExecutionContext {
+public:
+    explicit ExecutionContext(const BytecodeImage& image);
+
+    // Переменные — 0, массивы не созданы (их создаёт alloc_array).
+    void reset();
+    // Выполняет программу с начала на текущем состоянии. Ошибки — std::runtime_error,
+    // состояние на момент ошибки сохраняется.
+    void run();
+    // Выполнение с приостановкой: если функция ввода не задана, read не блокирует
+    // поток, а возвращает NEEDS_INPUT; resume передаёт значение и продолжает с той
+    // же инструкции. Так один поток может по очереди вести много программ.
+    ExecutionStatus start();
+    ExecutionStatus resume(int value);
+    bool is_waiting_for_input() const;
+    const std::string& get_input_target() const; // "x" или "a[3]" — что ждёт read
+
+    void set_input(ReadCallback callback);    // без ввода run завершает read ошибкой
+    void set_output(WriteCallback callback);  // без вывода print ничего не печатает
+    void set_trace(std::ostream* stream);     // подробный вывод выполнения, nullptr — нет
+    void set_profile(ExecutionProfile* profile);
+    void set_pc_publisher(std::atomic<size_t>* pc); // куда записывать pc (SamplingProfiler)
+
+    // Доступ к состоянию по индексу символа (см. BytecodeImage::symbols).
+    size_t get_symbol_count() const;
+    const std::string& get_symbol_name(size_t symbol) const;
+    bool has_variable(size_t symbol) const;
+    bool has_array(size_t symbol) const;
+    int& variable(size_t symbol);
+    std::vector<int>& array(size_t symbol);
+    void define_array(size_t symbol, const std::vector<int>& values);
+
+    // Доступ по имени; ошибки — как у таблицы символов.
+    int get_variable(const std::string& name) const;
+    void set_variable(const std::string& name, int value);
+    const std::vector<int>& get_array(const std::string& name) const;
+
+    size_t get_executed_count() const;
+    size_t get_jumps_count() const;
+
+private:
+    size_t find_symbol(const std::string& name) const;
+    void begin_execution();
+    ExecutionStatus execute_from(size_t start_pc, bool can_suspend);
+
+    const BytecodeImage& image;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, size_t> symbol_index;
+    std::vector<int> variables;
+    std::vector<std::vector<int>> arrays;
+    std::vector<char> is_variable;
+    std::vector<char> is_array;
+    std::vector<int> stack;
+
+    ReadCallback input;
+    WriteCallback output;
+    std::ostream* trace;
+    ExecutionProfile* profile;
+    std::atomic<size_t> own_pc;
+    std::atomic<size_t>* published_pc;
+    size_t executed_count;
+    size_t jumps_count;
+
+    size_t resume_pc;
+    bool waiting_for_input;
+    std::string input_target;
+    int pending_input;
+    bool has_pending_input;
+};
+
+#endif // EXECUTION_CONTEXT_H
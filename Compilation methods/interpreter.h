@@ -3,18 +3,33 @@
 
 #include "symbol_table.h"
 #include "ops.h"
+#include "bytecode.h"
+#include "profiler.h"
+#include <atomic>
 #include <stack>
 #include <vector>
 #include <string>
+#include <iostream>
 
 class Interpreter {
 public:
     Interpreter(SymbolTable& sym_table);
     void execute(const std::vector<OPS>& ops);
+    void execute(const BytecodeImage& image);
     void set_silent_mode(bool mode); // Новый метод
+    void set_io_streams(std::istream& input, std::ostream& output);
+    size_t get_executed_count() const; // число выполненных инструкций последнего execute
+    void set_profile(ExecutionProfile* profile); // nullptr — профилирование выключено
+    // pc выполняемой инструкции (или size_t(-1) вне execute) для SamplingProfiler.
+    const std::atomic<size_t>& get_current_pc() const;
 private:
     SymbolTable& sym_table;
     bool silent_mode_active; // Флаг для интерпретатора
+    std::istream* in;
+    std::ostream* out;
+    size_t executed_count;
+    ExecutionProfile* profile;
+    std::atomic<size_t> current_pc;
 };
 
 #endif
\ No newline at end of file
@@ -1,19 +1,85 @@
 #include "lexer.h"
+#include "stats.h"
 #include "error.h"
+#include "thread_pool.h"
+#include <algorithm>
 #include <cctype>
+#include <exception>
+#include <limits>
+#include <stdexcept>
 #include <sstream>
 #include <iostream> 
 
+// Меньшие куски не окупают запуск потоков.
+static const size_t PARALLEL_MIN_CHUNK = 1 << 20;
+// Кусков больше, чем потоков, чтобы потоки с быстрыми кусками забирали чужие.
+static const size_t PARALLEL_CHUNKS_PER_THREAD = 4;
+
+// Ключевые слова различаются по первой и последней букве: (первая + 3 * последняя) % 32
+// даёт каждому своё место в таблице (совершенный хеш). Идентификатор сравнивается
+// только со словом на своём месте. Имена массовых операций (fill, sum, ...) не
+// зарезервированы: их распознаёт парсер по следующей за именем скобке.
+static constexpr std::string_view KEYWORDS[] = {
+    "int", "if", "else", "while", "read", "print"
+};
+static constexpr size_t KEYWORD_SLOTS = 32;
+
+static constexpr size_t keyword_hash(std::string_view word) {
+    return (static_cast<unsigned char>(word.front()) + 3u * static_cast<unsigned char>(word.back())) % KEYWORD_SLOTS;
+}
+
+struct KeywordSlots {
+    std::string_view words[KEYWORD_SLOTS];
+    bool perfect;
+};
+
+static constexpr KeywordSlots make_keyword_slots() {
+    KeywordSlots slots{ {}, true };
+    for (std::string_view word : KEYWORDS) {
+        std::string_view& slot = slots.words[keyword_hash(word)];
+        if (!slot.empty()) slots.perfect = false;
+        slot = word;
+    }
+    return slots;
+}
+
+static constexpr KeywordSlots KEYWORD_TABLE = make_keyword_slots();
+static_assert(KEYWORD_TABLE.perfect, "keyword_hash must map every keyword to its own slot");
+
 Lexer::Lexer(const std::string& input)
-    : input(input), pos(0), line(1), line_pos(1), silent_mode_active(false) {
-    keywords = { "int", "if", "else", "while", "read", "print" };
-    init_transition_table();
+    : input(input), pos(0), first_line(1), silent_mode_active(false),
+      transition_table(get_tables().transition_table) {
+    if (input.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Source text is larger than 4 GB");
+    }
+}
+
+Lexer::Lexer(const std::string& input, int first_line) : Lexer(input) {
+    this->first_line = first_line;
+}
+
+// Таблица переходов общая для всех лексеров; строится один раз.
+const LexerTables& Lexer::get_tables() {
+    static const LexerTables tables = [] {
+        LexerTables result;
+        init_transition_table(result);
+        return result;
+    }();
+    return tables;
 }
 
 void Lexer::set_silent_mode(bool mode) {
     silent_mode_active = mode;
 }
 
+const NameTable& Lexer::get_names() const {
+    return names;
+}
+
+bool Lexer::is_keyword(std::string_view word) {
+    return !word.empty() && KEYWORD_TABLE.words[keyword_hash(word)] == word;
+}
+
 CharCategory Lexer::get_char_category(char c) const {
     if (std::isalpha(c) || c == '_') return CharCategory::LETTER;
     if (std::isdigit(c)) return CharCategory::DIGIT;
@@ -44,10 +110,10 @@ CharCategory Lexer::get_char_category(char c) const {
     }
 }
 
-std::string Lexer::get_token_type_from_action(int action_code, const std::string& lexeme) {
+std::string Lexer::get_token_type_from_action(int action_code, std::string_view lexeme) {
     switch (action_code) {
     case 0: case 26: case 27: // ID related actions
-        return keywords.count(lexeme) ? "KEYWORD" : "ID";
+        return is_keyword(lexeme) ? "KEYWORD" : "ID";
     case 1: case 28: case 29: // NUMBER related actions
         return "NUMBER";
     case 2: case 4: case 5: case 6: case 7: case 8: case 9:
@@ -60,12 +126,12 @@ std::string Lexer::get_token_type_from_action(int action_code, const std::string
     }
 }
 
-void Lexer::init_transition_table() {
+void Lexer::init_transition_table(LexerTables& tables) {
     using CC = CharCategory;
     using LS = LexState;
 
     auto add = [&](LS from, CC cat, LS to, int action) {
-        transition_table[{from, cat}] = { to, action };
+        tables.transition_table[{from, cat}] = { to, action };
     };
 
     // S - START state
@@ -134,9 +200,7 @@ void Lexer::init_transition_table() {
 std::vector<Token> Lexer::tokenize() {
     std::vector<Token> token_list;
     LexState current_lex_state = LexState::S;
-    std::string current_lexeme_value = "";
-    int lexeme_start_line_num = line;
-    int lexeme_start_char_pos = line_pos;
+    size_t lexeme_start = pos; // лексема — input[lexeme_start, pos), без копирования по символу
 
     while (pos <= input.length()) {
         char current_char = (pos < input.length()) ? input[pos] : '\0'; // EOF char
@@ -153,64 +217,38 @@ std::vector<Token> Lexer::tokenize() {
 
         // Skip whitespace/newline from S
         if (current_lex_state == LexState::S && (action_code == 22 || action_code == 23)) {
-            if (action_code == 22) { // Newline
-                line++;
-                line_pos = 1;
-            }
-            else { // Space
-                line_pos++;
-            }
             pos++;
-            current_lex_state = LexState::S;
-            current_lexeme_value = "";
-            lexeme_start_line_num = line;
-            lexeme_start_char_pos = line_pos;
             continue;
         }
 
         // Start of comment
         if (current_lex_state == LexState::D && next_lex_state == LexState::F) {
             pos++; // Consume the second '/'
-            line_pos++;
             current_lex_state = LexState::F;
-            current_lexeme_value = "";
-            lexeme_start_line_num = line;
-            lexeme_start_char_pos = line_pos;
             continue;
         }
 
         // Inside a comment
         if (current_lex_state == LexState::F) {
+            pos++;
             if (action_code == 22 || action_code == 25) { // End of comment (newline or EOF)
-                if (action_code == 22) {
-                    line++;
-                    line_pos = 1;
-                }
-                pos++;
                 current_lex_state = LexState::S;
-                current_lexeme_value = "";
-                lexeme_start_line_num = line;
-                lexeme_start_char_pos = line_pos;
                 if (current_char == '\0') break;
-                continue;
-            }
-            else {
-                pos++;
-                line_pos++;
-                continue;
             }
+            continue;
         }
 
         // Token completion
         if (next_lex_state == LexState::E) {
-            std::string token_val_to_add = current_lexeme_value;
+            std::string_view token_val_to_add = std::string_view(input).substr(lexeme_start, pos - lexeme_start);
             std::string token_type_str;
             int final_action_code = action_code;
             bool is_single_char_token = (current_lex_state == LexState::S);
+            uint32_t token_offset = static_cast<uint32_t>(is_single_char_token ? pos : lexeme_start);
 
             // Handle single-character tokens or EOF
             if (is_single_char_token) {
-                token_val_to_add = std::string(1, current_char);
+                token_val_to_add = std::string_view(&current_char, 1);
             }
 
             // Special handling for '=' and '==' or '/'
@@ -219,7 +257,6 @@ std::vector<Token> Lexer::tokenize() {
                     token_val_to_add = "==";
                     final_action_code = 11; // Action for ==
                     pos++; // Consume second '='
-                    line_pos++;
                 }
                 else {
                     token_val_to_add = "=";
@@ -235,61 +272,129 @@ std::vector<Token> Lexer::tokenize() {
 
             // Add token if valid
             if (token_type_str != "UNKNOWN" && !token_val_to_add.empty()) {
-                token_list.emplace_back(token_type_str, token_val_to_add, lexeme_start_line_num, lexeme_start_char_pos);
+                int name_id = token_type_str == "ID" ? names.intern(token_val_to_add) : -1;
+                token_list.emplace_back(token_type_str, std::string(token_val_to_add), token_offset, name_id);
+                STATS_INC(TOKENS);
             }
 
             // Handle EOF
             if (final_action_code == 25) {
                 if (!token_list.empty() && token_list.back().type == "EOF") { /* Already added */ }
                 else {
-                    token_list.emplace_back("EOF", "", lexeme_start_line_num, lexeme_start_char_pos);
+                    token_list.emplace_back("EOF", "", token_offset);
+                    STATS_INC(TOKENS);
                 }
                 break;
             }
 
             // Reset state
-            current_lexeme_value = "";
             current_lex_state = LexState::S;
 
             // Update position
-            if (is_single_char_token || final_action_code == 25) {
+            if (is_single_char_token) {
                 pos++;
-                if (char_cat == CharCategory::NEWLINE) {
-                    line++;
-                    line_pos = 1;
-                }
-                else if (current_char != '\0') {
-                    line_pos++;
-                }
             }
-
-            // Update lexeme start for next token
-            lexeme_start_line_num = line;
-            lexeme_start_char_pos = line_pos;
         }
         else if (next_lex_state == LexState::M) {
             std::stringstream ss_err;
             ss_err << "char '" << current_char << "'";
-            if (!current_lexeme_value.empty()) ss_err << " after '" << current_lexeme_value << "'";
-            throw Error("Lexical error", ss_err.str(), lexeme_start_line_num, lexeme_start_char_pos);
+            if (current_lex_state != LexState::S) ss_err << " after '" << std::string_view(input).substr(lexeme_start, pos - lexeme_start) << "'";
+            // Строки считаются только здесь: при разборе без ошибок индекс не нужен.
+            size_t error_offset = current_lex_state == LexState::S ? pos : lexeme_start;
+            SourceLines lines(input, first_line);
+            throw Error("Lexical error", ss_err.str(), lines.line(error_offset), lines.column(error_offset));
         }
         else { // Continue accumulating
             if (current_lex_state == LexState::S) {
-                lexeme_start_line_num = line;
-                lexeme_start_char_pos = line_pos;
+                lexeme_start = pos;
             }
-            current_lexeme_value += current_char;
             current_lex_state = next_lex_state;
             pos++;
-            if (char_cat == CharCategory::NEWLINE) {
-                line++;
-                line_pos = 1;
-            }
-            else {
-                line_pos++;
-            }
         }
         if (current_char == '\0') break;
     }
     return token_list;
-}
\ No newline at end of file
+}
+
+std::vector<Token> Lexer::tokenize_parallel(size_t thread_count) {
+    size_t chunk_count = std::min(thread_count * PARALLEL_CHUNKS_PER_THREAD, input.size() / PARALLEL_MIN_CHUNK);
+    if (thread_count < 2 || chunk_count < 2) {
+        return tokenize();
+    }
+
+    // Границы кусков — сразу после перевода строки. Смещения лексем куска отсчитываются
+    // от его начала и сдвигаются при склейке; номер первой строки нужен только для
+    // сообщений об ошибках и считается по переводам строк в предыдущих кусках.
+    struct Chunk {
+        size_t begin;
+        size_t end;
+        int first_line;
+        std::vector<Token> tokens;
+        NameTable names; // номера имён куска; при склейке переводятся в общую таблицу
+        bool stopped; // встретился '\0': tokenize дальше не читает
+        std::exception_ptr error;
+    };
+    std::vector<Chunk> chunks;
+    size_t begin = pos;
+    int chunk_line = first_line;
+    for (size_t i = 1; i <= chunk_count && begin < input.size(); ++i) {
+        size_t end = input.size();
+        if (i < chunk_count) {
+            size_t newline = input.find('\n', std::max(begin, input.size() / chunk_count * i));
+            if (newline != std::string::npos) end = newline + 1;
+        }
+        chunks.push_back({ begin, end, chunk_line, {}, {}, false, nullptr });
+        chunk_line += static_cast<int>(std::count(input.begin() + begin, input.begin() + end, '\n'));
+        begin = end;
+    }
+
+    {
+        ThreadPool pool(std::min(thread_count, chunks.size()));
+        for (Chunk& chunk : chunks) {
+            pool.submit([this, &chunk] {
+                try {
+                    Lexer chunk_lexer(input.substr(chunk.begin, chunk.end - chunk.begin), chunk.first_line);
+                    chunk_lexer.set_silent_mode(silent_mode_active);
+                    chunk.tokens = chunk_lexer.tokenize();
+                    chunk.names = std::move(chunk_lexer.names);
+                    chunk.stopped = chunk_lexer.pos < chunk_lexer.input.size();
+                }
+                catch (...) {
+                    chunk.error = std::current_exception();
+                }
+            });
+        }
+        pool.wait_idle();
+    }
+
+    // Первая по тексту ошибка — та, на которой остановился бы tokenize.
+    size_t token_count = 0;
+    for (const Chunk& chunk : chunks) {
+        token_count += chunk.tokens.size();
+    }
+    std::vector<Token> token_list;
+    token_list.reserve(token_count);
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        Chunk& chunk = chunks[i];
+        if (chunk.error) {
+            std::rethrow_exception(chunk.error);
+        }
+        bool last = chunk.stopped || i + 1 == chunks.size();
+        if (!last) {
+            chunk.tokens.pop_back(); // EOF куска
+        }
+        std::vector<int> name_ids(chunk.names.size());
+        for (size_t id = 0; id < name_ids.size(); ++id) {
+            name_ids[id] = names.intern(chunk.names.get(static_cast<int>(id)));
+        }
+        for (Token& token : chunk.tokens) {
+            token.offset += static_cast<uint32_t>(chunk.begin);
+            if (token.name_id >= 0) token.name_id = name_ids[static_cast<size_t>(token.name_id)];
+        }
+        token_list.insert(token_list.end(), std::make_move_iterator(chunk.tokens.begin()), std::make_move_iterator(chunk.tokens.end()));
+        if (last) break;
+    }
+    pos = input.size();
+    STATS_ADD(TOKENS, token_list.size());
+    return token_list;
+}
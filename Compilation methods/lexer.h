@@ -3,10 +3,12 @@
 
 #include "token.h"
 #include "error.h" 
+#include "name_table.h"
+#include "source_lines.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
-#include <set> // Добавлено
 
 enum class LexState {
     S, A, B, C, D, F, E, M
@@ -23,26 +25,40 @@ struct TransitionResult {
     int action_code;
 };
 
+struct LexerTables {
+    std::map<std::pair<LexState, CharCategory>, TransitionResult> transition_table;
+};
+
 class Lexer {
 public:
     Lexer(const std::string& input);
+    // Лексемы хранят смещение в тексте; строку и позицию даёт SourceLines(текст).
     std::vector<Token> tokenize();
+    // Для больших файлов: текст делится на куски по границам строк (комментарии
+    // заканчиваются переводом строки, многострочных лексем нет), куски разбираются
+    // параллельно на thread_count потоках, результаты склеиваются по порядку.
+    // Лексемы и ошибки — те же, что у tokenize; небольшой текст разбирается сразу.
+    std::vector<Token> tokenize_parallel(size_t thread_count);
     void set_silent_mode(bool mode); // Добавлено
+    // Имена идентификаторов, встреченных tokenize; Token::name_id — номер в этой таблице.
+    const NameTable& get_names() const;
+    static bool is_keyword(std::string_view word);
 
 private:
+    Lexer(const std::string& input, int first_line);
     CharCategory get_char_category(char c) const;
-    void init_transition_table();
-    std::string get_token_type_from_action(int action_code, const std::string& lexeme);
+    static const LexerTables& get_tables();
+    static void init_transition_table(LexerTables& tables);
+    std::string get_token_type_from_action(int action_code, std::string_view lexeme);
 
 
     std::string input;
     size_t pos;
-    int line;
-    int line_pos;
+    int first_line; // номер строки начала input (у кусков tokenize_parallel — не 1)
     bool silent_mode_active; // Добавлено
+    NameTable names;
 
-    std::map<std::pair<LexState, CharCategory>, TransitionResult> transition_table;
-    std::set<std::string> keywords;
+    const std::map<std::pair<LexState, CharCategory>, TransitionResult>& transition_table;
 };
 
 #endif
\ No newline at end of file
@@ -1,101 +1,175 @@
-#include "lexer.h"
-#include "parser.h"
-#include "interpreter.h"
+#include "driver.h"
+#include "benchmark.h"
+#include "server.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <vector>
 #include <string>
 #include <clocale>
+#include <thread>
+#include <memory>
 #include <windows.h>
 
 bool silent_mode = false;
+bool optimize_mode = true;
+CompilationCache* cache = nullptr;
+bool stats_mode = false;
+bool profile_mode = false;
+unsigned sample_rate = 0;
+size_t lexer_threads = 1;
+StatsLog* stats_log = nullptr;
 
-std::string read_file(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error: Cannot open file " << filename << std::endl;
-        exit(1);
-    }
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
+RunOptions get_run_options() {
+    RunOptions options = { silent_mode, optimize_mode, cache };
+    options.stats_mode = stats_mode;
+    options.stats_log = stats_log;
+    options.profile_mode = profile_mode;
+    options.sample_rate = sample_rate;
+    options.lexer_threads = lexer_threads;
+    return options;
 }
 
 void run_test(const std::string& filename) {
-    std::cout << "=== Running test: " << filename << " ===\n";
-    if (!silent_mode) {
-        std::string code_content = read_file(filename);
-        std::cout << "Code:\n" << code_content << std::endl;
+    // Готовый байткод (.opsb) выполняется без компиляции, как с ключом --run.
+    if (filename.size() > 5 && filename.compare(filename.size() - 5, 5, ".opsb") == 0) {
+        std::cout << "=== Running test: " << filename << " ===\n";
+        run_bytecode_file(filename, get_run_options());
+        return;
     }
+    run_file(filename, get_run_options(), std::cin, std::cout, std::cerr);
+}
 
-    std::string code = read_file(filename);
+int main(int argc, char* argv[]) {
+    SetConsoleOutputCP(65001);
+    std::locale::global(std::locale("en_US.UTF-8"));
 
-    try {
-        Lexer lexer(code);
-        std::vector<Token> tokens = lexer.tokenize();
-        if (!silent_mode) {
-            std::cout << "Tokens generated successfully (" << tokens.size() << " tokens)\n";
-            std::cout << "Tokens:\n";
-            for (const auto& t : tokens) {
-                std::cout << t.type << " '" << t.value << "' (line " << t.line << ")\n";
-            }
+    std::string batch_list;
+    size_t batch_jobs = std::thread::hardware_concurrency();
+    std::string compile_source, compile_output, run_file, disasm_file, bench_dir, microbench_dir;
+    std::string cache_dir, stats_json;
+    std::string server_socket, client_socket, client_list, stop_socket;
+    uint64_t cache_limit = 64ULL * 1024 * 1024;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--silent") {
+            silent_mode = true;
         }
-
-        SymbolTable sym_table;
-        Parser parser(sym_table);
-        parser.set_silent_mode(silent_mode);
-
-        std::vector<OPS> ops_list = parser.parse(tokens);
-
-        Interpreter interpreter(sym_table);
-        interpreter.set_silent_mode(silent_mode);
-
-        if (!silent_mode) {
-            std::cout << "Symbol table before execution:\n";
-            sym_table.print();
+        else if (arg == "--no-opt") {
+            optimize_mode = false;
         }
-
-        bool needs_input = false;
-        for (const auto& op_item : ops_list) {
-            if (op_item.operation == "r" || op_item.operation == "array_read") {
-                needs_input = true;
-                break;
-            }
+        else if (arg == "--batch" && i + 1 < argc) {
+            batch_list = argv[++i];
         }
-        if (needs_input && !silent_mode) {
-            std::cout << "Please provide input for 'read' operations: ";
+        else if (arg == "--jobs" && i + 1 < argc) {
+            batch_jobs = static_cast<size_t>(std::stoul(argv[++i]));
         }
-        interpreter.execute(ops_list);
-
-        if (!silent_mode) {
-            std::cout << "Execution finished. Symbol table final state:\n";
-            sym_table.print();
+        else if (arg == "--compile" && i + 2 < argc) {
+            compile_source = argv[++i];
+            compile_output = argv[++i];
+        }
+        else if (arg == "--bench" && i + 1 < argc) {
+            bench_dir = argv[++i];
+        }
+        else if (arg == "--microbench" && i + 1 < argc) {
+            microbench_dir = argv[++i];
+        }
+        else if (arg == "--run" && i + 1 < argc) {
+            run_file = argv[++i];
+        }
+        else if (arg == "--disasm" && i + 1 < argc) {
+            disasm_file = argv[++i];
+        }
+        else if (arg == "--server" && i + 1 < argc) {
+            server_socket = argv[++i];
+        }
+        else if (arg == "--client" && i + 2 < argc) {
+            client_socket = argv[++i];
+            client_list = argv[++i];
+        }
+        else if (arg == "--stop-server" && i + 1 < argc) {
+            stop_socket = argv[++i];
+        }
+        else if (arg == "--cache" && i + 1 < argc) {
+            cache_dir = argv[++i];
+        }
+        else if (arg == "--stats") {
+            stats_mode = true;
+        }
+        else if (arg == "--memory") {
+            stats_mode = true;
+            set_memory_tracking(true);
+        }
+        else if (arg == "--profile") {
+            profile_mode = true;
+        }
+        else if (arg == "--sample" && i + 1 < argc) {
+            sample_rate = static_cast<unsigned>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--stats-json" && i + 1 < argc) {
+            stats_json = argv[++i];
+        }
+        else if (arg == "--cache-limit" && i + 1 < argc) {
+            cache_limit = std::stoull(argv[++i]);
         }
-        std::cout << "Test " << filename << " completed successfully\n";
     }
-    catch (const std::exception& e) {
-        std::cerr << "Error in " << filename << ": " << e.what() << "\n";
+
+    silent_mode = true;
+    lexer_threads = batch_jobs;
+
+    std::unique_ptr<CompilationCache> cache_holder;
+    if (!cache_dir.empty()) {
+        cache_holder = std::make_unique<CompilationCache>(cache_dir, cache_limit);
+        cache = cache_holder.get();
     }
-    if (!silent_mode) {
-        std::cout << std::endl;
+    StatsLog stats_holder;
+    if (!stats_json.empty()) {
+        stats_log = &stats_holder;
     }
-}
 
-int main(int argc, char* argv[]) {
-    SetConsoleOutputCP(65001);
-    std::locale::global(std::locale("en_US.UTF-8"));
-
-    if (argc > 1 && std::string(argv[1]) == "--silent") {
-        silent_mode = true;
+    if (!bench_dir.empty()) {
+        return run_benchmarks(bench_dir);
+    }
+    if (!microbench_dir.empty()) {
+        return run_microbenchmarks(microbench_dir);
+    }
+    if (!compile_source.empty()) {
+        return compile_to_file(compile_source, compile_output, get_run_options());
+    }
+    if (!run_file.empty()) {
+        return run_bytecode_file(run_file, get_run_options());
+    }
+    if (!disasm_file.empty()) {
+        return disassemble_file(disasm_file);
+    }
+    if (!server_socket.empty()) {
+        return run_server(server_socket, batch_jobs, get_run_options());
+    }
+    if (!client_socket.empty()) {
+        return run_client(client_socket, client_list);
+    }
+    if (!stop_socket.empty()) {
+        return stop_server(stop_socket);
+    }
+    if (!batch_list.empty()) {
+        int result = run_batch(batch_list, batch_jobs, get_run_options());
+        if (stats_log && !stats_log->write_json(stats_json)) {
+            std::cerr << "Error: Cannot write file " << stats_json << std::endl;
+            return 1;
+        }
+        return result;
     }
 
-    silent_mode = true;
-    
-    std::vector<std::string> test_files = { "test1.txt", "test2.txt", "test3.1.txt", "test3.2.txt", "test3.3.txt", "test4.txt", "test5.txt", "test6.txt" };
+    std::vector<std::string> test_files = { "test1.txt", "test2.txt", "test3.1.txt", "test3.2.txt", "test3.3.txt", "test4.txt", "test5.txt", "test6.txt", "test7.txt", "test8.1.txt", "test8.2.txt", "test9.txt", "test10.txt", "test11.opsb" };
     for (const auto& file : test_files) {
         run_test(file);
     }
+    if (cache) {
+        print_cache_stats(*cache);
+    }
+    if (stats_log && !stats_log->write_json(stats_json)) {
+        std::cerr << "Error: Cannot write file " << stats_json << std::endl;
+    }
     std::cout << "=== All tests completed ===\n";
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "name_table.h"
+#include <cstring>
+#include <functional>
+
+static const size_t INITIAL_SLOTS = 64;
+
+NameTable::NameTable() : arena(std::make_unique<std::pmr::monotonic_buffer_resource>()), slots(INITIAL_SLOTS, -1) {
+}
+
+int NameTable::intern(std::string_view name) {
+    size_t mask = slots.size() - 1;
+    size_t slot = std::hash<std::string_view>()(name) & mask;
+    while (slots[slot] >= 0) {
+        if (names[static_cast<size_t>(slots[slot])] == name) {
+            return slots[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    int id = static_cast<int>(names.size());
+    char* text = static_cast<char*>(arena->allocate(name.size() == 0 ? 1 : name.size(), 1));
+    std::memcpy(text, name.data(), name.size());
+    names.emplace_back(text, name.size());
+    slots[slot] = id;
+    if (names.size() * 2 > slots.size()) {
+        grow();
+    }
+    return id;
+}
+
+// Заполнение не выше половины: цепочки проб остаются короткими.
+void NameTable::grow() {
+    std::vector<int> larger(slots.size() * 2, -1);
+    size_t mask = larger.size() - 1;
+    for (size_t id = 0; id < names.size(); ++id) {
+        size_t slot = std::hash<std::string_view>()(names[id]) & mask;
+        while (larger[slot] >= 0) {
+            slot = (slot + 1) & mask;
+        }
+        larger[slot] = static_cast<int>(id);
+    }
+    slots.swap(larger);
+}
+
+std::string_view NameTable::get(int id) const {
+    return names[static_cast<size_t>(id)];
+}
+
+size_t NameTable::size() const {
+    return names.size();
+}
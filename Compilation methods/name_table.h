@@ -0,0 +1,28 @@
+#ifndef NAME_TABLE_H
+#define NAME_TABLE_H
+
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+// Таблица имён: каждое различное имя хранится один раз и получает номер по порядку
+// появления. Номер и текст имени не меняются, пока таблица существует.
+class NameTable {
+public:
+    NameTable();
+    int intern(std::string_view name); // уже известное имя — прежний номер
+    std::string_view get(int id) const;
+    size_t size() const;
+
+private:
+    void grow();
+
+    // Текст имён лежит в арене: она берёт память большими блоками и освобождает их
+    // все сразу вместе с таблицей, на каждое имя отдельного выделения нет.
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+    std::vector<std::string_view> names;
+    std::vector<int> slots; // открытая адресация: номер имени или -1
+};
+
+#endif // NAME_TABLE_H
@@ -6,7 +6,19 @@
 struct OPS {
     std::string operation;
     std::string operand;
-    OPS(const std::string& op, const std::string& oper = "") : operation(op), operand(oper) {}
+    int line; // строка исходного текста, из которой получена операция (0 — неизвестна)
+    OPS(const std::string& op, const std::string& oper = "", int line = 0) : operation(op), operand(oper), line(line) {}
 };
 
+// Операции над двумя массивами хранят оба имени в операнде: "приёмник,источник".
+inline bool is_array_pair_operation(const std::string& op) {
+    return op == "array_copy" || op == "array_add_array" || op == "array_sub_array" || op == "array_mul_array";
+}
+
+// Временные переменные, которые вводит оптимизатор: "$t0", "$t1", ... Такие имена
+// невозможны в исходном тексте и в таблицу символов не попадают.
+inline bool is_temporary_variable(const std::string& name) {
+    return !name.empty() && name[0] == '$';
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,982 @@
+#include "optimizer.h"
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <map>
+#include <set>
+
+Optimizer::Optimizer() : silent_mode_active(false), out(&std::cout) {}
+
+void Optimizer::set_silent_mode(bool mode) {
+    silent_mode_active = mode;
+}
+
+void Optimizer::set_output_stream(std::ostream& stream) {
+    out = &stream;
+}
+
+std::vector<OPS> Optimizer::optimize(const std::vector<OPS>& ops) {
+    std::vector<OPS> result = recognize_loop_idioms(ops);
+    result = eliminate_bounds_checks(result);
+    // Распознавание идиом и устранение проверок ищут циклы в том виде, в каком их строит
+    // парсер, поэтому переворот идёт после них. Вынос инвариантов, устранение общих
+    // подвыражений и понижение стоимости операций рассчитаны на перевёрнутые циклы.
+    result = invert_loops(result);
+    result = hoist_loop_invariants(result);
+    result = eliminate_common_subexpressions(result);
+    result = reduce_strength(result);
+
+    if (!silent_mode_active) {
+        *out << "Optimized OPS (" << result.size() << " operations):\n";
+        for (size_t i = 0; i < result.size(); ++i) {
+            *out << i << ": " << result[i].operation << (result[i].operand.empty() ? "" : " " + result[i].operand) << "\n";
+        }
+    }
+    return result;
+}
+
+bool is_jump_operation(const std::string& op) {
+    return op == "j" || op == "jf" || op == "jt";
+}
+
+size_t get_jump_target(const OPS& op) {
+    try {
+        return std::stoul(op.operand);
+    }
+    catch (const std::exception&) {
+        throw std::runtime_error("Invalid target for " + op.operation + ": " + op.operand);
+    }
+}
+
+bool is_number_operand(const std::string& operand) {
+    return !operand.empty() && std::all_of(operand.begin(), operand.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; });
+}
+
+void get_stack_effect(const OPS& op, int& pops, int& pushes) {
+    const std::string& o = op.operation;
+    pops = 0;
+    pushes = 0;
+    if (o.empty() || o == "array_sum" || o == "array_min" || o == "array_max") {
+        pushes = 1;
+    }
+    else if (o == "+" || o == "-" || o == "*" || o == "/" || o == ">" || o == "<" || o == "==" || o == "&" || o == "|") {
+        pops = 2; pushes = 1;
+    }
+    else if (o == "~" || o == "!" || o == "array_get" || o == "array_get_unchecked" || o == "shl" || o == "div_const") {
+        pops = 1; pushes = 1;
+    }
+    else if (o == "jf" || o == "jt" || o == "=" || o == "alloc_array" || o == "array_read" || o == "w"
+        || o == "array_fill" || o == "array_add" || o == "array_sub" || o == "array_mul") {
+        pops = 1;
+    }
+    else if (o == "array_set" || o == "array_set_unchecked") {
+        pops = 2;
+    }
+    else if (o == "init_array") {
+        pops = std::stoi(op.operand);
+    }
+    else if (o == "array_fill_range") {
+        pops = 3; pushes = 1;
+    }
+    else if (o == "array_read_range" || o == "array_print_range" || o == "array_copy_range") {
+        pops = 2; pushes = 1;
+    }
+    else if (o == "j" || o == "r" || o == "array_sort" || is_array_pair_operation(o)) {
+        // не трогают стек
+    }
+    else {
+        throw std::runtime_error("Unknown operation in optimizer: " + o);
+    }
+}
+
+std::string get_written_variable(const OPS& op) {
+    if (op.operation == "=" || op.operation == "r") {
+        return op.operand;
+    }
+    return "";
+}
+
+size_t find_expression_start(const std::vector<OPS>& ops, size_t end) {
+    int need = 1;
+    size_t k = end;
+    while (k > 0) {
+        --k;
+        if (is_jump_operation(ops[k].operation)) {
+            return std::string::npos;
+        }
+        int pops, pushes;
+        get_stack_effect(ops[k], pops, pushes);
+        need -= pushes;
+        if (need < 0) {
+            return std::string::npos;
+        }
+        need += pops;
+        if (need == 0) {
+            return k;
+        }
+    }
+    return std::string::npos;
+}
+
+std::vector<LoopInfo> find_loops(const std::vector<OPS>& ops) {
+    std::vector<LoopInfo> loops;
+    for (size_t b = 0; b < ops.size(); ++b) {
+        if (ops[b].operation != "j") continue;
+        size_t head = get_jump_target(ops[b]);
+        if (head > b) continue;
+        // Условие цикла заканчивается первым jf, который выходит сразу за обратный переход.
+        for (size_t c = head; c < b; ++c) {
+            if (ops[c].operation == "jf" && get_jump_target(ops[c]) == b + 1) {
+                loops.push_back({ head, c, b, b + 1 });
+                break;
+            }
+        }
+    }
+    return loops;
+}
+
+bool is_jump_target_in_range(const std::vector<OPS>& ops, size_t begin, size_t end) {
+    for (size_t k = 0; k < ops.size(); ++k) {
+        if (k >= begin && k < end) continue;
+        if (!is_jump_operation(ops[k].operation)) continue;
+        size_t t = get_jump_target(ops[k]);
+        if (t > begin && t < end) return true;
+    }
+    return false;
+}
+
+std::vector<OPS> apply_ops_patches(const std::vector<OPS>& ops, std::vector<OpsPatch> patches) {
+    std::sort(patches.begin(), patches.end(), [](const OpsPatch& a, const OpsPatch& b) {
+        return a.begin < b.begin || (a.begin == b.begin && a.end < b.end);
+    });
+    for (size_t p = 1; p < patches.size(); ++p) {
+        if (patches[p].begin < patches[p - 1].end) {
+            throw std::logic_error("Overlapping OPS patches at " + std::to_string(patches[p].begin));
+        }
+    }
+
+    const size_t npos = std::string::npos;
+    std::vector<size_t> new_pos(ops.size() + 1, npos);
+    std::vector<OPS> result;
+    result.reserve(ops.size());
+
+    size_t next_patch = 0;
+    size_t i = 0;
+    while (i <= ops.size()) {
+        if (next_patch < patches.size() && patches[next_patch].begin == i) {
+            const OpsPatch& patch = patches[next_patch++];
+            if (new_pos[i] == npos) {
+                new_pos[i] = result.size();
+            }
+            size_t inserted = result.size();
+            result.insert(result.end(), patch.code.begin(), patch.code.end());
+            // Новые операции относятся к той же строке, что и заменённый участок.
+            int line = i < ops.size() ? ops[i].line : (i > 0 ? ops[i - 1].line : 0);
+            for (size_t k = inserted; k < result.size(); ++k) {
+                if (result[k].line == 0) result[k].line = line;
+            }
+            if (patch.end > patch.begin) {
+                i = patch.end;
+            }
+            continue;
+        }
+        if (new_pos[i] == npos) {
+            new_pos[i] = result.size();
+        }
+        if (i == ops.size()) break;
+        result.push_back(ops[i]);
+        ++i;
+    }
+
+    // Все операнды переходов (и в старом коде, и во вставках) заданы в старых адресах.
+    for (OPS& op : result) {
+        if (!is_jump_operation(op.operation)) continue;
+        size_t t = get_jump_target(op);
+        if (t > ops.size() || new_pos[t] == npos) {
+            throw std::logic_error("Jump into replaced OPS range: target " + op.operand);
+        }
+        op.operand = std::to_string(new_pos[t]);
+    }
+    return result;
+}
+
+// Операция над значениями в стеке, которая не может завершиться ошибкой.
+static bool is_pure_operation(const std::string& op) {
+    static const char* pure_ops[] = { "+", "-", "*", "~", ">", "<", "==", "&", "|", "!", "shl", "div_const" };
+    return std::find(std::begin(pure_ops), std::end(pure_ops), op) != std::end(pure_ops);
+}
+
+// Участок [begin, end) не меняет ни переменную var, ни массив array,
+// не ссылается на них и не может завершиться ошибкой времени выполнения.
+static bool is_pure_invariant_expression(const std::vector<OPS>& ops, size_t begin, size_t end,
+    const std::string& var, const std::string& array) {
+    for (size_t k = begin; k < end; ++k) {
+        const OPS& op = ops[k];
+        if (op.operation.empty()) {
+            if (op.operand == var || op.operand == array) return false;
+            continue;
+        }
+        if (!is_pure_operation(op.operation)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Распознаёт циклы вида while (i < n) { <тело над arr[i]>; i = i + 1; } и заменяет их
+// одной операцией над диапазоном [i, n), которая проверяет границы один раз до начала работы
+// и оставляет в стеке итоговое значение i. Поддерживаются тела:
+//   arr[i] = выраж;     (выраж без i и arr, без / и обращений к массивам) -> array_fill_range
+//   arr[i] = src[i];                                                      -> array_copy_range
+//   read(arr[i]);                                                         -> array_read_range
+//   print(arr[i]);                                                        -> array_print_range
+std::vector<OPS> Optimizer::recognize_loop_idioms(const std::vector<OPS>& ops) {
+    std::vector<OpsPatch> patches;
+
+    for (const LoopInfo& loop : find_loops(ops)) {
+        size_t h = loop.head;
+        size_t b = loop.back_jump;
+        // Условие: "" i; "" n; <; jf exit
+        if (loop.exit_jump != h + 3 || b < h + 8) continue;
+        const OPS& cond_var = ops[h];
+        const OPS& cond_bound = ops[h + 1];
+        if (!cond_var.operation.empty() || is_number_operand(cond_var.operand)) continue;
+        if (!cond_bound.operation.empty() || cond_bound.operand == cond_var.operand) continue;
+        if (ops[h + 2].operation != "<") continue;
+        const std::string& iv = cond_var.operand;
+
+        // Хвост тела: "" i; "" 1; +; = i
+        size_t inc = b - 4;
+        if (!(ops[inc].operation.empty() && ops[inc].operand == iv
+            && ops[inc + 1].operation.empty() && ops[inc + 1].operand == "1"
+            && ops[inc + 2].operation == "+"
+            && ops[inc + 3].operation == "=" && ops[inc + 3].operand == iv)) continue;
+
+        size_t body = h + 4;
+        if (!ops[body].operation.empty() || ops[body].operand != iv) continue;
+        if (is_jump_target_in_range(ops, h, b + 1)) continue;
+
+        std::vector<OPS> code;
+        code.emplace_back("", iv);
+        code.push_back(cond_bound);
+        std::string kind;
+        size_t body_len = inc - body;
+
+        if (body_len == 2 && ops[body + 1].operation == "array_read") {
+            kind = "array_read_range";
+            code.emplace_back(kind, ops[body + 1].operand);
+        }
+        else if (body_len == 3 && ops[body + 1].operation == "array_get" && ops[body + 2].operation == "w") {
+            kind = "array_print_range";
+            code.emplace_back(kind, ops[body + 1].operand);
+        }
+        else if (body_len == 4 && ops[body + 1].operation.empty() && ops[body + 1].operand == iv
+            && ops[body + 2].operation == "array_get" && ops[body + 3].operation == "array_set"
+            && ops[body + 2].operand != ops[body + 3].operand) {
+            kind = "array_copy_range";
+            code.emplace_back(kind, ops[body + 3].operand + "," + ops[body + 2].operand);
+        }
+        else if (body_len >= 3 && ops[inc - 1].operation == "array_set") {
+            const std::string& arr = ops[inc - 1].operand;
+            if (find_expression_start(ops, inc - 1) != body + 1) continue;
+            if (cond_bound.operand == arr) continue;
+            if (!is_pure_invariant_expression(ops, body + 1, inc - 1, iv, arr)) continue;
+            kind = "array_fill_range";
+            code.insert(code.end(), ops.begin() + body + 1, ops.begin() + (inc - 1));
+            code.emplace_back(kind, arr);
+        }
+        else {
+            continue;
+        }
+        code.emplace_back("=", iv);
+
+        if (!silent_mode_active) {
+            *out << "Loop at " << h << ".." << b << " replaced with " << kind << "\n";
+        }
+        patches.push_back({ h, b + 1, code });
+    }
+
+    if (patches.empty()) return ops;
+    return apply_ops_patches(ops, patches);
+}
+
+// Линейная форма sum(coef[v] * v) + constant над целочисленными переменными.
+struct LinearForm {
+    std::map<std::string, long long> coef;
+    long long constant = 0;
+};
+
+static bool build_linear_form(const std::vector<OPS>& ops, size_t begin, size_t end, LinearForm& result) {
+    std::vector<LinearForm> stack;
+    for (size_t k = begin; k < end; ++k) {
+        const OPS& op = ops[k];
+        if (op.operation.empty()) {
+            LinearForm f;
+            if (is_number_operand(op.operand)) f.constant = std::stoll(op.operand);
+            else f.coef[op.operand] = 1;
+            stack.push_back(f);
+        }
+        else if (op.operation == "~" && !stack.empty()) {
+            LinearForm& f = stack.back();
+            for (auto& c : f.coef) c.second = -c.second;
+            f.constant = -f.constant;
+        }
+        else if ((op.operation == "+" || op.operation == "-" || op.operation == "*") && stack.size() >= 2) {
+            LinearForm right = stack.back(); stack.pop_back();
+            LinearForm& left = stack.back();
+            if (op.operation == "*") {
+                // Линейность сохраняется, только если один из множителей — константа.
+                if (!right.coef.empty() && !left.coef.empty()) return false;
+                const LinearForm& factor = right.coef.empty() ? right : left;
+                LinearForm product = right.coef.empty() ? left : right;
+                for (auto& c : product.coef) c.second *= factor.constant;
+                product.constant *= factor.constant;
+                left = product;
+            }
+            else {
+                long long sign = op.operation == "+" ? 1 : -1;
+                for (const auto& c : right.coef) left.coef[c.first] += sign * c.second;
+                left.constant += sign * right.constant;
+            }
+        }
+        else {
+            return false;
+        }
+    }
+    if (stack.size() != 1) return false;
+    result = stack.back();
+    return true;
+}
+
+// Вычисление ops[begin, end) в int не переполняется ни на одном шаге. Диапазоны значений
+// считаются в long long: числа — сами себе, неотрицательные переменные — [0, INT_MAX],
+// остальные — весь int. Линейная форма складывает выражение точно, а в int оно может
+// перейти через границу и стать большим положительным, поэтому без такой проверки
+// граница цикла ничего не доказывает.
+static bool is_int_safe_expression(const std::vector<OPS>& ops, size_t begin, size_t end,
+                                   const std::set<std::string>& non_negative) {
+    const long long int_min = std::numeric_limits<int>::min();
+    const long long int_max = std::numeric_limits<int>::max();
+    std::vector<std::pair<long long, long long>> stack;
+    for (size_t k = begin; k < end; ++k) {
+        const OPS& op = ops[k];
+        if (op.operation.empty()) {
+            if (is_number_operand(op.operand)) {
+                long long value = std::stoll(op.operand);
+                stack.push_back({ value, value });
+            }
+            else if (non_negative.count(op.operand)) stack.push_back({ 0, int_max });
+            else stack.push_back({ int_min, int_max });
+        }
+        else if (op.operation == "~" && !stack.empty()) {
+            auto& range = stack.back();
+            range = { -range.second, -range.first };
+        }
+        else if ((op.operation == "+" || op.operation == "-" || op.operation == "*") && stack.size() >= 2) {
+            auto right = stack.back(); stack.pop_back();
+            auto& left = stack.back();
+            if (op.operation == "+") left = { left.first + right.first, left.second + right.second };
+            else if (op.operation == "-") left = { left.first - right.second, left.second - right.first };
+            else {
+                long long products[] = { left.first * right.first, left.first * right.second,
+                                         left.second * right.first, left.second * right.second };
+                left = { *std::min_element(products, products + 4), *std::max_element(products, products + 4) };
+            }
+        }
+        else {
+            return false;
+        }
+        if (stack.back().first < int_min || stack.back().second > int_max) return false;
+    }
+    return stack.size() == 1;
+}
+
+// Шаг v = v + c, выполняемый в теле цикла while (v < E) до любых других записей в v:
+// условие даёт v < E <= INT_MAX, поэтому при c = 1 (или при числовой границе E с
+// E - 1 + c <= INT_MAX) сложение не переполняется.
+static bool is_guarded_increment(const std::vector<OPS>& ops, const std::vector<LoopInfo>& loops,
+                                 size_t p, const std::string& v, long long step) {
+    for (const LoopInfo& loop : loops) {
+        if (!(loop.exit_jump < p && p < loop.back_jump)) continue;
+        size_t h = loop.head;
+        size_t c = loop.exit_jump;
+        if (c < h + 3 || ops[c - 1].operation != "<") continue;
+        if (!ops[h].operation.empty() || ops[h].operand != v) continue;
+        if (find_expression_start(ops, c - 1) != h + 1) continue;
+        LinearForm bound;
+        if (!build_linear_form(ops, h + 1, c - 1, bound)) continue;
+        if (step > 1 && !(bound.coef.empty() && bound.constant - 1 + step <= std::numeric_limits<int>::max())) continue;
+        if (is_jump_target_in_range(ops, h, loop.back_jump + 1)) continue;
+
+        bool clean = true;
+        for (size_t k = h; k < p && clean; ++k) {
+            if (get_written_variable(ops[k]) == v) clean = false;
+        }
+        // Во вложенном цикле шаг повторялся бы без проверки условия.
+        for (const LoopInfo& inner : loops) {
+            if (inner.head > h && inner.back_jump < loop.back_jump && inner.head <= p && p <= inner.back_jump) clean = false;
+        }
+        if (clean) return true;
+    }
+    return false;
+}
+
+// Переменные, значение которых никогда не бывает отрицательным. Доказываются только
+// ограниченные значения: числа, копии таких переменных, результат операций над диапазоном
+// и шаг счётчика цикла на константу под условием v < E. Суммы и произведения переменных
+// не доказываются: при переполнении int они становятся отрицательными.
+static std::set<std::string> find_non_negative_variables(const std::vector<OPS>& ops) {
+    std::vector<LoopInfo> loops = find_loops(ops);
+    std::set<std::string> result;
+    for (const OPS& op : ops) {
+        std::string v = get_written_variable(op);
+        if (!v.empty()) result.insert(v);
+        if (op.operation.empty() && !is_number_operand(op.operand)) result.insert(op.operand);
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t p = 0; p < ops.size(); ++p) {
+            std::string v = get_written_variable(ops[p]);
+            if (v.empty() || !result.count(v)) continue;
+            bool proven = false;
+            size_t start = ops[p].operation == "=" ? find_expression_start(ops, p) : std::string::npos;
+            if (start != std::string::npos) {
+                std::vector<bool> stack;
+                proven = true;
+                for (size_t k = start; k < p && proven; ++k) {
+                    const OPS& op = ops[k];
+                    if (op.operation.empty()) {
+                        stack.push_back(is_number_operand(op.operand) || result.count(op.operand) > 0);
+                    }
+                    else if (op.operation.size() > 6 && op.operation.compare(op.operation.size() - 6, 6, "_range") == 0) {
+                        // Операции над диапазоном оставляют max(начало, конец): знак определяет начало.
+                        size_t operands = op.operation == "array_fill_range" ? 3 : 2;
+                        if (stack.size() < operands) { proven = false; break; }
+                        stack.resize(stack.size() - operands + 1);
+                    }
+                    else {
+                        proven = false;
+                    }
+                }
+                proven = proven && stack.size() == 1 && stack.back();
+
+                LinearForm form;
+                if (!proven && build_linear_form(ops, start, p, form) && form.constant >= 0) {
+                    auto self = form.coef.find(v);
+                    proven = form.coef.size() == 1 && self != form.coef.end() && self->second == 1
+                        && is_guarded_increment(ops, loops, p, v, form.constant);
+                }
+            }
+            if (!proven) {
+                result.erase(v);
+                changed = true;
+            }
+        }
+    }
+    return result;
+}
+
+// Заменяет array_get/array_set на варианты без проверки границ там, где доказано,
+// что индекс лежит в [0, размер массива). Доказательство строится для циклов
+// while (j < E), внутри которых индекс имеет вид j + k (k >= 0), а E + k <= размер
+// массива при неотрицательных j и переменных, входящих в E с отрицательным знаком.
+// Где доказать не удалось, остаётся проверяемая операция с прежним текстом ошибки.
+std::vector<OPS> Optimizer::eliminate_bounds_checks(const std::vector<OPS>& ops) {
+    std::vector<LoopInfo> loops = find_loops(ops);
+
+    // Размер массива: переменная или число, которое после alloc_array не меняется.
+    std::map<std::string, size_t> last_write;
+    for (size_t k = 0; k < ops.size(); ++k) {
+        std::string written = get_written_variable(ops[k]);
+        if (!written.empty()) last_write[written] = k;
+    }
+    std::map<std::string, OPS> array_sizes;
+    for (size_t p = 1; p < ops.size(); ++p) {
+        if (ops[p].operation != "alloc_array" || !ops[p - 1].operation.empty()) continue;
+        bool in_loop = false;
+        for (const LoopInfo& loop : loops) {
+            if (loop.head <= p && p <= loop.back_jump) in_loop = true;
+        }
+        if (in_loop) continue;
+        auto write = last_write.find(ops[p - 1].operand);
+        if (write == last_write.end() || write->second < p) {
+            array_sizes.emplace(ops[p].operand, ops[p - 1]);
+        }
+    }
+    if (array_sizes.empty()) return ops;
+
+    std::set<std::string> non_negative = find_non_negative_variables(ops);
+    auto is_written_in = [&ops](const std::set<std::string>& vars, size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            if (vars.count(get_written_variable(ops[k]))) return true;
+        }
+        return false;
+    };
+
+    std::vector<OPS> result = ops;
+    size_t eliminated = 0;
+    for (size_t q = 0; q < ops.size(); ++q) {
+        bool is_get = ops[q].operation == "array_get";
+        if (!is_get && ops[q].operation != "array_set") continue;
+        auto size_it = array_sizes.find(ops[q].operand);
+        if (size_it == array_sizes.end()) continue;
+
+        size_t index_end = q;
+        if (!is_get) {
+            index_end = find_expression_start(ops, q);
+            if (index_end == std::string::npos) continue;
+        }
+        size_t index_start = find_expression_start(ops, index_end);
+        LinearForm index;
+        if (index_start == std::string::npos || !build_linear_form(ops, index_start, index_end, index)) continue;
+        if (index.coef.size() != 1 || index.coef.begin()->second != 1 || index.constant < 0) continue;
+        const std::string& iv = index.coef.begin()->first;
+        if (!non_negative.count(iv)) continue;
+        // Размер массива после alloc_array положителен и дальше не меняется.
+        std::set<std::string> bounded_variables = non_negative;
+        if (!is_number_operand(size_it->second.operand)) bounded_variables.insert(size_it->second.operand);
+
+        bool proven = false;
+        for (const LoopInfo& loop : loops) {
+            if (proven) break;
+            if (!(loop.exit_jump < q && q < loop.back_jump)) continue;
+            // Условие: "" j; E; <; jf exit
+            size_t h = loop.head;
+            size_t c = loop.exit_jump;
+            if (c < h + 3 || ops[c - 1].operation != "<") continue;
+            if (!ops[h].operation.empty() || ops[h].operand != iv) continue;
+            if (find_expression_start(ops, c - 1) != h + 1) continue;
+            LinearForm bound;
+            if (!build_linear_form(ops, h + 1, c - 1, bound)) continue;
+            if (!is_int_safe_expression(ops, h + 1, c - 1, bounded_variables)) continue;
+            if (is_jump_target_in_range(ops, h, loop.back_jump + 1)) continue;
+
+            // j + k < E + k <= size  <=>  E + k - size <= 0
+            LinearForm diff = bound;
+            diff.constant += index.constant;
+            const OPS& size_op = size_it->second;
+            if (is_number_operand(size_op.operand)) diff.constant -= std::stoll(size_op.operand);
+            else diff.coef[size_op.operand] -= 1;
+            bool bounded = diff.constant <= 0;
+            std::set<std::string> used = { iv };
+            for (const auto& c_item : diff.coef) {
+                if (c_item.second > 0 || (c_item.second < 0 && !non_negative.count(c_item.first))) bounded = false;
+            }
+            for (const auto& c_item : bound.coef) used.insert(c_item.first);
+            if (!bounded) continue;
+
+            // Значения j и переменных из E не должны меняться между проверкой условия и доступом.
+            if (is_written_in(used, h, q)) continue;
+            bool stable = true;
+            for (const LoopInfo& inner : loops) {
+                if (inner.head > h && inner.back_jump < loop.back_jump && inner.head <= q && q <= inner.back_jump
+                    && is_written_in(used, inner.head, inner.back_jump + 1)) stable = false;
+            }
+            proven = stable;
+        }
+        if (proven) {
+            result[q].operation = is_get ? "array_get_unchecked" : "array_set_unchecked";
+            ++eliminated;
+        }
+    }
+
+    if (!silent_mode_active && eliminated > 0) {
+        *out << "Bounds checks eliminated: " << eliminated << "\n";
+    }
+    return result;
+}
+
+// Переворачивает циклы while: условие проверяется один раз перед входом, а вместо
+// обратного перехода в конце тела стоит копия условия, переходящая в начало тела по истине:
+//   head: C; jf exit; body: ...; j head; exit:  ->  head: C; jf exit; body: ...; C; jt body; exit:
+// Итерация выполняет один переход вместо двух. Внутренние переходы копии (сокращённое
+// вычисление в скобках) ведут в исходное условие — оно вычисляет то же самое.
+std::vector<OPS> Optimizer::invert_loops(const std::vector<OPS>& ops) {
+    std::vector<OpsPatch> patches;
+    for (const LoopInfo& loop : find_loops(ops)) {
+        // Условие заканчивается последним jf на выход: остальные порождает сокращённое &.
+        size_t cond_end = loop.exit_jump;
+        for (size_t k = loop.exit_jump + 1; k < loop.back_jump; ++k) {
+            if (ops[k].operation == "jf" && get_jump_target(ops[k]) == loop.exit) cond_end = k;
+        }
+        std::vector<OPS> code(ops.begin() + loop.head, ops.begin() + cond_end + 1);
+        code.back().operation = "jt";
+        code.back().operand = std::to_string(cond_end + 1);
+        if (!silent_mode_active) {
+            *out << "Loop at " << loop.head << ".." << loop.back_jump << " inverted\n";
+        }
+        patches.push_back({ loop.back_jump, loop.back_jump + 1, code });
+    }
+
+    if (patches.empty()) return ops;
+    return apply_ops_patches(ops, patches);
+}
+
+// Число уже занятых имён временных переменных: новые получают номера после них.
+static size_t count_temporaries(const std::vector<OPS>& ops) {
+    size_t count = 0;
+    for (const OPS& op : ops) {
+        if (is_temporary_variable(op.operand) && op.operand.size() > 2 && is_number_operand(op.operand.substr(2))) {
+            count = std::max(count, static_cast<size_t>(std::stoul(op.operand.substr(2))) + 1);
+        }
+    }
+    return count;
+}
+
+// Выносит из циклов выражения, значение которых не меняется между итерациями
+// (n - 1 в while (i < n - 1)), во временные переменные $tN, вычисляемые один раз.
+// Работает на перевёрнутых циклах "C; jf exit; тело; C; jt тело": вычисления вставляются
+// перед последним операндом проверки на входе, заменяются вхождения и в ней, и в теле,
+// и в копии условия. Выносятся только выражения из чисел, переменных, не изменяемых
+// в цикле (= и read), и операций, которые не могут завершиться ошибкой (без / и
+// массивов), — поэтому их можно вычислить и тогда, когда тело не выполнится ни разу.
+std::vector<OPS> Optimizer::hoist_loop_invariants(const std::vector<OPS>& ops) {
+    struct InvertedLoop {
+        size_t entry; // начало последнего операнда проверки на входе
+        size_t back_jump;
+    };
+    std::vector<InvertedLoop> loops;
+    for (size_t b = 0; b < ops.size(); ++b) {
+        if (ops[b].operation != "jt") continue;
+        size_t body = get_jump_target(ops[b]);
+        if (body == 0 || body > b) continue;
+        const OPS& guard = ops[body - 1];
+        if (guard.operation != "jf" || get_jump_target(guard) != b + 1) continue;
+        size_t entry = find_expression_start(ops, body - 1);
+        // В цикл можно попасть только через entry: иначе вычисления перед ним пропускаются.
+        if (entry == std::string::npos || is_jump_target_in_range(ops, entry, b + 1)) continue;
+        loops.push_back({ entry, b });
+    }
+    // Сначала внешние циклы: выражение, не зависящее от обоих, выносится за внешний.
+    std::stable_sort(loops.begin(), loops.end(), [](const InvertedLoop& a, const InvertedLoop& b) {
+        return a.back_jump - a.entry > b.back_jump - b.entry;
+    });
+
+    std::set<std::string> arrays;
+    for (const OPS& op : ops) {
+        if (op.operation == "alloc_array") arrays.insert(op.operand);
+    }
+    std::vector<OpsPatch> patches;
+    std::vector<char> replaced(ops.size(), 0);
+    size_t temporaries = count_temporaries(ops);
+
+    for (const InvertedLoop& loop : loops) {
+        std::set<std::string> written;
+        for (size_t k = loop.entry; k <= loop.back_jump; ++k) {
+            std::string v = get_written_variable(ops[k]);
+            if (!v.empty()) written.insert(v);
+        }
+
+        std::vector<OPS> preheader;
+        std::map<std::string, std::string> temporary_for;
+        // Корень выражения в ОПС стоит после операндов: идя с конца, находим наибольшие выражения.
+        for (size_t k = loop.back_jump; k-- > loop.entry;) {
+            if (!is_pure_operation(ops[k].operation)) continue;
+            size_t start = find_expression_start(ops, k + 1);
+            if (start == std::string::npos || start < loop.entry) continue;
+            bool invariant = !is_jump_target_in_range(ops, start, k + 1);
+            std::string text;
+            for (size_t m = start; m <= k && invariant; ++m) {
+                const OPS& op = ops[m];
+                if (replaced[m]) invariant = false;
+                else if (op.operation.empty()) {
+                    invariant = is_number_operand(op.operand) || (!written.count(op.operand) && !arrays.count(op.operand));
+                }
+                else {
+                    invariant = is_pure_operation(op.operation);
+                }
+                text += (text.empty() ? "" : " ") + (op.operation.empty() ? op.operand : op.operation);
+            }
+            if (!invariant) continue;
+
+            auto found = temporary_for.find(text);
+            if (found == temporary_for.end()) {
+                std::string name = "$t" + std::to_string(temporaries++);
+                found = temporary_for.emplace(text, name).first;
+                preheader.insert(preheader.end(), ops.begin() + start, ops.begin() + k + 1);
+                preheader.emplace_back("=", name, ops[k].line);
+                if (!silent_mode_active) {
+                    *out << "Loop at " << loop.entry << ".." << loop.back_jump << ": " << text << " hoisted to " << name << "\n";
+                }
+            }
+            std::fill(replaced.begin() + start, replaced.begin() + k + 1, 1);
+            patches.push_back({ start, k + 1, { OPS("", found->second, ops[k].line) } });
+            k = start;
+        }
+        if (!preheader.empty()) {
+            patches.push_back({ loop.entry, loop.entry, preheader });
+        }
+    }
+
+    if (patches.empty()) return ops;
+    return apply_ops_patches(ops, patches);
+}
+
+// Значение в стеке при нумерации значений: номер (-1 — неизвестно) и участок [start, end]
+// блока, который его вычисляет (start == npos — участок не целиком в блоке).
+struct NumberedValue {
+    int value;
+    size_t start;
+    size_t end;
+};
+
+// Вычисление значения в блоке; holder — переменная, в которой оно уже лежит.
+struct ValueOccurrence {
+    int value;
+    size_t start;
+    size_t end;
+    std::string holder;
+};
+
+static void number_block_values(const std::vector<OPS>& ops, size_t begin, size_t end,
+    size_t& temporaries, std::vector<OpsPatch>& patches, size_t& eliminated) {
+    const size_t npos = std::string::npos;
+    int next_value = 0;
+    std::map<std::string, int> known;           // ключ вычисления -> номер значения
+    std::map<std::string, int> variable_value;
+    std::map<int, std::set<std::string>> holders;
+    std::map<std::string, int> array_version;
+    int memory_version = 0;                     // меняется операциями, которые могут изменить любой массив
+    std::vector<NumberedValue> stack;
+    std::vector<ValueOccurrence> occurrences;
+
+    auto lookup = [&](const std::string& key) {
+        auto it = known.find(key);
+        if (it != known.end()) return it->second;
+        known.emplace(key, next_value);
+        return next_value++;
+    };
+    auto variable = [&](const std::string& name) {
+        auto it = variable_value.find(name);
+        if (it != variable_value.end()) return it->second;
+        int v = next_value++;
+        variable_value[name] = v;
+        holders[v].insert(name);
+        return v;
+    };
+    auto assign = [&](const std::string& name, int v) {
+        auto it = variable_value.find(name);
+        if (it != variable_value.end()) holders[it->second].erase(name);
+        if (v < 0) v = next_value++;
+        variable_value[name] = v;
+        holders[v].insert(name);
+    };
+    auto element_key = [&](const std::string& array, int index) {
+        return "[] " + array + " " + std::to_string(array_version[array]) + " " + std::to_string(memory_version) + " " + std::to_string(index);
+    };
+
+    for (size_t k = begin; k < end; ++k) {
+        const OPS& op = ops[k];
+        const std::string& o = op.operation;
+        int pops, pushes;
+        get_stack_effect(op, pops, pushes);
+        std::vector<NumberedValue> args(pops, NumberedValue{ -1, npos, npos });
+        for (int p = pops - 1; p >= 0 && !stack.empty(); --p) {
+            args[p] = stack.back();
+            stack.pop_back();
+        }
+        bool known_args = true;
+        size_t start = args.empty() ? k : args[0].start;
+        for (size_t a = 0; a < args.size(); ++a) {
+            if (args[a].value < 0) known_args = false;
+            size_t next = a + 1 < args.size() ? args[a + 1].start : k;
+            if (args[a].start == npos || args[a].end + 1 != next) start = npos;
+        }
+
+        int value = -1;
+        if (o.empty()) {
+            value = is_number_operand(op.operand) ? lookup("# " + op.operand) : variable(op.operand);
+        }
+        else if (is_pure_operation(o) || o == "/") {
+            if (known_args) {
+                std::vector<int> operands;
+                for (const NumberedValue& a : args) operands.push_back(a.value);
+                if (o == "+" || o == "*" || o == "==" || o == "&" || o == "|") std::sort(operands.begin(), operands.end());
+                std::string key = o;
+                for (int v : operands) key += " " + std::to_string(v);
+                value = lookup(key);
+            }
+        }
+        else if (o == "array_get" || o == "array_get_unchecked") {
+            if (known_args) value = lookup(element_key(op.operand, args[0].value));
+        }
+        else if (o == "array_sum" || o == "array_min" || o == "array_max") {
+            value = lookup(o + " " + op.operand + " " + std::to_string(array_version[op.operand]) + " " + std::to_string(memory_version));
+        }
+        else if (o == "=" || o == "r") {
+            assign(op.operand, o == "=" ? args[0].value : -1);
+        }
+        else if (o == "array_set" || o == "array_set_unchecked") {
+            ++array_version[op.operand];
+            // Следующее чтение того же элемента вернёт записанное значение.
+            if (known_args) known[element_key(op.operand, args[0].value)] = args[1].value;
+        }
+        else if (o == "array_read") {
+            ++array_version[op.operand];
+        }
+        else if (!is_jump_operation(o) && o != "w") {
+            ++memory_version;
+        }
+
+        if (pushes == 0) continue;
+        if (!o.empty() && value >= 0 && start != npos) {
+            const std::set<std::string>& current = holders[value];
+            occurrences.push_back({ value, start, k, current.empty() ? "" : *current.begin() });
+        }
+        stack.push_back({ value, o.empty() || value >= 0 ? start : npos, k });
+    }
+
+    // Сначала длинные выражения: вложенные в заменённые вхождения больше не вычисляются.
+    std::map<int, std::vector<const ValueOccurrence*>> by_value;
+    std::map<int, size_t> longest;
+    for (const ValueOccurrence& occurrence : occurrences) {
+        by_value[occurrence.value].push_back(&occurrence);
+        longest[occurrence.value] = std::max(longest[occurrence.value], occurrence.end - occurrence.start + 1);
+    }
+    std::vector<int> values;
+    for (const auto& entry : by_value) values.push_back(entry.first);
+    std::stable_sort(values.begin(), values.end(), [&](int a, int b) { return longest[a] > longest[b]; });
+
+    std::vector<char> replaced(end - begin, 0);
+    std::set<size_t> insertions;
+    for (int v : values) {
+        std::vector<const ValueOccurrence*> list;
+        for (const ValueOccurrence* occurrence : by_value[v]) {
+            bool free = std::find(replaced.begin() + (occurrence->start - begin), replaced.begin() + (occurrence->end - begin + 1), 1)
+                == replaced.begin() + (occurrence->end - begin + 1);
+            auto inserted = insertions.upper_bound(occurrence->start);
+            if (free && (inserted == insertions.end() || *inserted > occurrence->end)) {
+                list.push_back(occurrence);
+            }
+        }
+        // Значение уже лежит в переменной — читаем её.
+        std::vector<const ValueOccurrence*> computed;
+        for (const ValueOccurrence* occurrence : list) {
+            if (occurrence->holder.empty()) {
+                computed.push_back(occurrence);
+                continue;
+            }
+            patches.push_back({ occurrence->start, occurrence->end + 1, { OPS("", occurrence->holder, ops[occurrence->end].line) } });
+            std::fill(replaced.begin() + (occurrence->start - begin), replaced.begin() + (occurrence->end - begin + 1), 1);
+            ++eliminated;
+        }
+        if (computed.size() < 2 || computed[0]->end + 1 >= end) continue;
+
+        // Иначе первое вычисление сохраняется во временную. Это окупается, только если
+        // повторные вычисления длиннее двух добавленных операций (= $tN и чтение $tN).
+        long long saving = -2;
+        for (size_t i = 1; i < computed.size(); ++i) {
+            saving += static_cast<long long>(computed[i]->end - computed[i]->start);
+        }
+        if (saving <= 0) continue;
+        std::string temporary = "$t" + std::to_string(temporaries++);
+        int line = ops[computed[0]->end].line;
+        patches.push_back({ computed[0]->end + 1, computed[0]->end + 1, { OPS("=", temporary, line), OPS("", temporary, line) } });
+        insertions.insert(computed[0]->end + 1);
+        for (size_t i = 1; i < computed.size(); ++i) {
+            const ValueOccurrence* occurrence = computed[i];
+            patches.push_back({ occurrence->start, occurrence->end + 1, { OPS("", temporary, ops[occurrence->end].line) } });
+            std::fill(replaced.begin() + (occurrence->start - begin), replaced.begin() + (occurrence->end - begin + 1), 1);
+            ++eliminated;
+        }
+    }
+}
+
+// Нумерация значений в базовых блоках: выражение, значение которого уже вычислено
+// в этом блоке, не вычисляется повторно. Если значение лежит в переменной
+// (x = a + b; ... a + b), читается она; иначе первое вычисление сохраняется во
+// временную $tN, когда это сокращает число операций. Повторные чтения a[i]
+// используются, пока в блоке нет записи в a (после a[i] = v чтение a[i] — это v).
+std::vector<OPS> Optimizer::eliminate_common_subexpressions(const std::vector<OPS>& ops) {
+    // Блоки начинаются с начала ОПС, целей переходов и операций после переходов.
+    std::vector<char> block_start(ops.size() + 1, 0);
+    block_start[0] = 1;
+    block_start[ops.size()] = 1;
+    for (size_t k = 0; k < ops.size(); ++k) {
+        if (!is_jump_operation(ops[k].operation)) continue;
+        block_start[k + 1] = 1;
+        size_t target = get_jump_target(ops[k]);
+        if (target <= ops.size()) block_start[target] = 1;
+    }
+
+    std::vector<OpsPatch> patches;
+    size_t temporaries = count_temporaries(ops);
+    size_t eliminated = 0;
+    for (size_t begin = 0; begin < ops.size();) {
+        size_t end = begin + 1;
+        while (!block_start[end]) ++end;
+        number_block_values(ops, begin, end, temporaries, patches, eliminated);
+        begin = end;
+    }
+
+    if (!silent_mode_active && eliminated > 0) {
+        *out << "Common subexpressions eliminated: " << eliminated << "\n";
+    }
+    if (patches.empty()) return ops;
+    return apply_ops_patches(ops, patches);
+}
+
+// Значение операции "" с числом, если оно помещается в int.
+static bool get_small_constant(const OPS& op, int& value) {
+    if (!op.operation.empty() || !is_number_operand(op.operand) || op.operand.size() > 10) return false;
+    long long v = std::stoll(op.operand);
+    if (v > std::numeric_limits<int>::max()) return false;
+    value = static_cast<int>(v);
+    return true;
+}
+
+static int get_power_of_two(int value) {
+    if (value <= 0 || (value & (value - 1)) != 0) return -1;
+    int power = 0;
+    while ((1 << power) != value) ++power;
+    return power;
+}
+
+// Умножение и деление на числа: x * 1 и x / 1 -> x, умножение на 2^k (с любой стороны)
+// -> shl k, деление на d >= 2 -> div_const d (умножение на обратное без проверки на ноль).
+// Деление на 0 остаётся обычным /, чтобы ошибка выдавалась как раньше.
+std::vector<OPS> Optimizer::reduce_strength(const std::vector<OPS>& ops) {
+    std::vector<OpsPatch> patches;
+    for (size_t k = 1; k < ops.size(); ++k) {
+        const std::string& o = ops[k].operation;
+        if (o != "*" && o != "/") continue;
+        size_t right = find_expression_start(ops, k);
+        if (right == std::string::npos || right == 0) continue;
+        size_t left = find_expression_start(ops, right);
+        if (left == std::string::npos || is_jump_target_in_range(ops, left, k + 1)) continue;
+
+        int c = 0;
+        int line = ops[k].line;
+        if (right == k - 1 && get_small_constant(ops[k - 1], c)) {
+            if (c == 1) {
+                patches.push_back({ k - 1, k + 1, {} });
+            }
+            else if (o == "*" && get_power_of_two(c) > 0) {
+                patches.push_back({ k - 1, k + 1, { OPS("shl", std::to_string(get_power_of_two(c)), line) } });
+            }
+            else if (o == "/" && c >= 2) {
+                patches.push_back({ k - 1, k + 1, { OPS("div_const", std::to_string(c), line) } });
+            }
+            else {
+                continue;
+            }
+        }
+        else if (o == "*" && left == right - 1 && get_small_constant(ops[left], c) && (c == 1 || get_power_of_two(c) > 0)) {
+            patches.push_back({ left, left + 1, {} });
+            patches.push_back({ k, k + 1, c == 1 ? std::vector<OPS>() : std::vector<OPS>{ OPS("shl", std::to_string(get_power_of_two(c)), line) } });
+        }
+        else {
+            continue;
+        }
+        if (!silent_mode_active) {
+            *out << "Strength reduced " << o << " at " << k << "\n";
+        }
+    }
+
+    if (patches.empty()) return ops;
+    return apply_ops_patches(ops, patches);
+}
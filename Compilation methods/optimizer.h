@@ -0,0 +1,56 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "ops.h"
+#include <vector>
+#include <string>
+#include <ostream>
+
+// Цикл while в ОПС в том виде, в каком его строит парсер:
+// head: условие; jf exit; тело; back_jump: j head; exit: ...
+struct LoopInfo {
+    size_t head;
+    size_t exit_jump;
+    size_t back_jump;
+    size_t exit;
+};
+
+// Замена участка [begin, end) списка ОПС новой последовательностью (begin == end — вставка).
+// Переходы на begin ведут на начало первой из замен, начинающихся в этой позиции.
+struct OpsPatch {
+    size_t begin;
+    size_t end;
+    std::vector<OPS> code;
+};
+
+class Optimizer {
+public:
+    Optimizer();
+    void set_silent_mode(bool mode);
+    void set_output_stream(std::ostream& stream);
+    std::vector<OPS> optimize(const std::vector<OPS>& ops);
+
+private:
+    std::vector<OPS> recognize_loop_idioms(const std::vector<OPS>& ops);
+    std::vector<OPS> eliminate_bounds_checks(const std::vector<OPS>& ops);
+    std::vector<OPS> invert_loops(const std::vector<OPS>& ops);
+    std::vector<OPS> hoist_loop_invariants(const std::vector<OPS>& ops);
+    std::vector<OPS> eliminate_common_subexpressions(const std::vector<OPS>& ops);
+    std::vector<OPS> reduce_strength(const std::vector<OPS>& ops);
+
+    bool silent_mode_active;
+    std::ostream* out;
+};
+
+// Общие средства анализа ОПС, которыми пользуются проходы оптимизатора.
+bool is_jump_operation(const std::string& op);
+size_t get_jump_target(const OPS& op);
+void get_stack_effect(const OPS& op, int& pops, int& pushes);
+size_t find_expression_start(const std::vector<OPS>& ops, size_t end);
+std::vector<LoopInfo> find_loops(const std::vector<OPS>& ops);
+bool is_jump_target_in_range(const std::vector<OPS>& ops, size_t begin, size_t end);
+bool is_number_operand(const std::string& operand);
+std::string get_written_variable(const OPS& op);
+std::vector<OPS> apply_ops_patches(const std::vector<OPS>& ops, std::vector<OpsPatch> patches);
+
+#endif // OPTIMIZER_H
@@ -1,17 +1,41 @@
 #include "parser.h"
+#include "stats.h"
 #include <stdexcept>
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <limits>
 
+static const std::string START_SYMBOL = "Программа";
+static const std::string END_SYMBOL = "EOF";
+static const Token END_TOKEN("EOF", "", 0);
+// Массовые операции над массивами: операторы и свёртки внутри арифметических выражений.
+static const std::vector<std::string> BULK_STATEMENTS = { "fill", "copy", "add", "sub", "mul", "sort" };
+static const std::vector<std::string> BULK_REDUCTIONS = { "sum", "min", "max" };
+
 Parser::Parser(SymbolTable& sym_table) :
     sym_table(sym_table),
+    tokens_list(nullptr),
+    source_lines(nullptr),
+    bulk_operand_start(0),
+    is_array_access(false),
+    current_initializer_count(0),
     current_token_idx(0),
     silent_mode_active(false),
-    current_initializer_count(0),
-    is_array_access(false) {
-    initialize_grammar_and_table();
+    out(&std::cout),
+    tables(get_tables()) {
+}
+
+// Таблицы не зависят от программы: строятся при первом создании парсера и
+// дальше используются всеми парсерами (в том числе из разных потоков) только на чтение.
+const ParserTables& Parser::get_tables() {
+    static const ParserTables tables = [] {
+        ParserTables result;
+        initialize_grammar_and_table(result);
+        number_symbols(result);
+        return result;
+    }();
+    return tables;
 }
 
 void Parser::set_silent_mode(bool mode) {
@@ -19,82 +43,106 @@ void Parser::set_silent_mode(bool mode) {
     sym_table.set_silent_mode(mode);
 }
 
+void Parser::set_output_stream(std::ostream& stream) {
+    out = &stream;
+    sym_table.set_output_stream(stream);
+}
+
+int Parser::line_of(const Token& token) const {
+    return source_lines->line(token.offset);
+}
+
+int Parser::column_of(const Token& token) const {
+    return source_lines->column(token.offset);
+}
+
+// Лексема для строки и позиции в ошибках действий: последняя прочитанная.
+const Token& Parser::get_action_token() const {
+    if (current_token_idx > 0 && current_token_idx <= tokens_list->size()) {
+        return (*tokens_list)[current_token_idx - 1];
+    }
+    return current_token_idx < tokens_list->size() ? (*tokens_list)[current_token_idx] : END_TOKEN;
+}
+
 bool Parser::is_variable_declared(const std::string& name) const {
     return sym_table.exists(name) || declared_arrays_set.count(name);
 }
 
-std::string Parser::get_current_input_terminal_string(const Token& token) {
-    if (token.type == "KEYWORD" || token.type == "SYMBOL") {
+static bool is_bulk_operation_name(const std::string& name) {
+    return std::find(BULK_STATEMENTS.begin(), BULK_STATEMENTS.end(), name) != BULK_STATEMENTS.end()
+        || std::find(BULK_REDUCTIONS.begin(), BULK_REDUCTIONS.end(), name) != BULK_REDUCTIONS.end();
+}
+
+// Имя массовой операции — терминал только перед "(": иначе это обычный
+// идентификатор, и sum, min, fill и т.д. можно объявлять как переменные.
+bool Parser::is_builtin_call(size_t index) const {
+    const std::vector<Token>& tokens = *tokens_list;
+    if (index + 1 >= tokens.size() || tokens[index].type != "ID") return false;
+    const Token& next = tokens[index + 1];
+    if (next.type != "SYMBOL" || next.value != "(") return false;
+    return is_bulk_operation_name(tokens[index].value);
+}
+
+const std::string& Parser::get_input_terminal_string(size_t index) const {
+    static const std::string ID_TERMINAL = "ID";
+    static const std::string NUMBER_TERMINAL = "NUMBER";
+    const Token& token = index < tokens_list->size() ? (*tokens_list)[index] : END_TOKEN;
+    if (token.type == "KEYWORD" || token.type == "SYMBOL" || is_builtin_call(index)) {
         return token.value;
     }
     else if (token.type == "ID") {
-        return "ID";
+        return ID_TERMINAL;
     }
     else if (token.type == "NUMBER") {
-        return "NUMBER";
+        return NUMBER_TERMINAL;
     }
     else if (token.type == "EOF") {
-        return "EOF";
+        return END_SYMBOL;
     }
     throw std::runtime_error("Unknown token type for input terminal string: " + token.type);
 }
 
-bool Parser::match_and_advance(const std::string& expected_terminal_in_rule) {
-    if (current_token_idx >= tokens_list.size()) {
-        return expected_terminal_in_rule == "EOF";
+bool Parser::match_and_advance(int expected_terminal) {
+    if (current_token_idx >= tokens_list->size()) {
+        return expected_terminal == tables.end_symbol;
     }
 
-    const Token& current_token = tokens_list[current_token_idx];
-    bool matched = false;
+    const Token& current_token = (*tokens_list)[current_token_idx];
+    const InputSymbol& input = input_symbols[current_token_idx];
+    bool matched = expected_terminal == input.terminal
+        || (input.word_class >= 0 && (expected_terminal == input.word_class || expected_terminal == tables.id_or_number_symbol));
 
-    if (expected_terminal_in_rule == current_token.value && (current_token.type == "KEYWORD" || current_token.type == "SYMBOL")) {
-        matched = true;
+    if (!matched) {
+        return false;
     }
-    else if (expected_terminal_in_rule == "ID" && current_token.type == "ID") {
+    // Имя массовой операции, сопоставленное с самой операцией, не меняет id_for_actions.
+    if (input.word_class == tables.id_symbol && (expected_terminal == tables.id_symbol || expected_terminal == tables.id_or_number_symbol)) {
         id_for_actions = current_token.value;
         number_for_actions.clear();
-        matched = true;
     }
-    else if (expected_terminal_in_rule == "NUMBER" && current_token.type == "NUMBER") {
+    else if (input.word_class == tables.number_symbol) {
         number_for_actions = current_token.value;
         id_for_actions.clear();
-        matched = true;
     }
-    else if (expected_terminal_in_rule == "IDorNUMBER" && (current_token.type == "ID" || current_token.type == "NUMBER")) {
-        if (current_token.type == "ID") {
-            id_for_actions = current_token.value;
-            number_for_actions.clear();
-        }
-        else {
-            number_for_actions = current_token.value;
-            id_for_actions.clear();
-        }
-        matched = true;
-    }
-    else if (expected_terminal_in_rule == "EOF" && current_token.type == "EOF") {
-        matched = true;
-    }
-
-    if (matched) {
-        if (!silent_mode_active) {
-            std::cout << "Matched and consumed: " << expected_terminal_in_rule << " ('" << current_token.value
-                << "'), id_for_actions: '" << id_for_actions << "', number_for_actions: '" << number_for_actions << "'\n";
-        }
-        current_token_idx++;
-        return true;
+    if (!silent_mode_active) {
+        *out << "Matched and consumed: " << tables.symbols[expected_terminal] << " ('" << current_token.value
+            << "'), id_for_actions: '" << id_for_actions << "', number_for_actions: '" << number_for_actions << "'\n";
     }
-    return false;
+    current_token_idx++;
+    return true;
 }
 
-void Parser::initialize_grammar_and_table() {
+void Parser::initialize_grammar_and_table(ParserTables& tables) {
+    std::vector<Rule>& grammar_rules = tables.grammar_rules;
+    std::map<std::string, std::map<std::string, int>>& ll_parse_table = tables.ll_parse_table;
     grammar_rules = {
         { "Программа", {"СписокОператоров", "EOF"}, 0 },
         { "СписокОператоров", {"Оператор", "СписокОператоров"}, 1 },
         { "СписокОператоров", {}, 2 },
         { "Оператор", {"int", "ID", "#ACTION_STORE_ID_FOR_LHS", "ХвостОбъявления"}, 3 },
         { "Оператор", {"ID", "#ACTION_STORE_ID_FOR_LHS", "#ACTION_CHECK_VAR_EXISTS", "ХвостИспользования"}, 4 },
-        { "Оператор", {"if", "(", "ЛогВыраж", "#ACTION_PROG1", ")", "{", "ПрограммаВнутриБлока", "}", "Альтернатива", "#ACTION_PROG3_IF_END"}, 5 },
-        { "Оператор", {"while", "#ACTION_PROG4", "(", "ЛогВыраж", "#ACTION_PROG1", ")", "{", "ПрограммаВнутриБлока", "}", "#ACTION_PROG5"}, 6 },
+        { "Оператор", {"if", "(", "Условие", "#ACTION_PROG1", ")", "{", "ПрограммаВнутриБлока", "}", "Альтернатива", "#ACTION_PROG3_IF_END"}, 5 },
+        { "Оператор", {"while", "#ACTION_PROG4", "(", "Условие", "#ACTION_PROG1", ")", "{", "ПрограммаВнутриБлока", "}", "#ACTION_PROG5"}, 6 },
         { "Оператор", {"read", "(", "ДоступКПеременнойДляRead", ")", ";"}, 7 },
         { "Оператор", {"print", "(", "ЛогВыраж", ")", ";", "#ACTION_PRINT"}, 8 },
         { "ПрограммаВнутриБлока", {"СписокОператоров"}, 9 },
@@ -126,11 +174,11 @@ void Parser::initialize_grammar_and_table() {
         { "ПервичноеАрифм", {"(", "АрифмВыраж", ")"}, 35 },
         { "ХвостИндекса", {"[", "АрифмВыраж", "]", "#ACTION_SET_ARRAY_ACCESS"}, 36 },
         { "ХвостИндекса", {}, 37 },
-        { "ЛогВыраж", {"ЛогИЛИ_Терм", "ЛогИЛИ_Прод"}, 38 },
-        { "ЛогИЛИ_Прод", {"|", "ЛогИЛИ_Терм", "#ACTION_GEN_OR", "ЛогИЛИ_Прод"}, 39 },
+        { "ЛогВыраж", {"#ACTION_LOGIC_BEGIN", "ЛогИЛИ_Терм", "ЛогИЛИ_Прод", "#ACTION_LOGIC_VALUE"}, 38 },
+        { "ЛогИЛИ_Прод", {"|", "#ACTION_OR_SKIP", "ЛогИЛИ_Терм", "ЛогИЛИ_Прод"}, 39 },
         { "ЛогИЛИ_Прод", {}, 40 },
         { "ЛогИЛИ_Терм", {"ЛогИ_Терм", "ЛогИ_Прод"}, 41 },
-        { "ЛогИ_Прод", {"&", "ЛогИ_Терм", "#ACTION_GEN_AND", "ЛогИ_Прод"}, 42 },
+        { "ЛогИ_Прод", {"&", "#ACTION_AND_SKIP", "ЛогИ_Терм", "ЛогИ_Прод"}, 42 },
         { "ЛогИ_Прод", {}, 43 },
         { "ЛогИ_Терм", {"!", "ЛогИ_Терм", "#ACTION_GEN_NOT"}, 44 },
         { "ЛогИ_Терм", {"СравнениеИлиПервичноеЛог"}, 45 },
@@ -141,7 +189,19 @@ void Parser::initialize_grammar_and_table() {
         { "ОператорСравнения", {">", "#ACTION_SET_COMP_OP_GT"}, 50 },
         { "ОператорСравнения", {"<", "#ACTION_SET_COMP_OP_LT"}, 51 },
         { "ОператорСравнения", {"==", "#ACTION_SET_COMP_OP_EQ"}, 52 },
-        { "ДоступКПеременнойДляRead", {"ID", "#ACTION_STORE_ID_FOR_LHS", "ХвостИндекса", "#ACTION_READ_VAR_OR_ARRAY"}, 53 }
+        { "ДоступКПеременнойДляRead", {"ID", "#ACTION_STORE_ID_FOR_LHS", "ХвостИндекса", "#ACTION_READ_VAR_OR_ARRAY"}, 53 },
+        { "Оператор", {"fill", "(", "ID", "#ACTION_STORE_ID_FOR_LHS", ",", "АрифмВыраж", ")", ";", "#ACTION_BULK_FILL"}, 54 },
+        { "Оператор", {"copy", "(", "ID", "#ACTION_STORE_ID_FOR_LHS", ",", "ID", "#ACTION_STORE_BULK_SRC", ")", ";", "#ACTION_BULK_COPY"}, 55 },
+        { "Оператор", {"add", "(", "ID", "#ACTION_STORE_ID_FOR_LHS", ",", "#ACTION_BULK_OPERAND_START", "АрифмВыраж", ")", ";", "#ACTION_BULK_ADD"}, 56 },
+        { "Оператор", {"sub", "(", "ID", "#ACTION_STORE_ID_FOR_LHS", ",", "#ACTION_BULK_OPERAND_START", "АрифмВыраж", ")", ";", "#ACTION_BULK_SUB"}, 57 },
+        { "Оператор", {"mul", "(", "ID", "#ACTION_STORE_ID_FOR_LHS", ",", "#ACTION_BULK_OPERAND_START", "АрифмВыраж", ")", ";", "#ACTION_BULK_MUL"}, 58 },
+        { "Оператор", {"sort", "(", "ID", "#ACTION_STORE_ID_FOR_LHS", ")", ";", "#ACTION_BULK_SORT"}, 59 },
+        { "ПервичноеАрифм", {"sum", "(", "ID", "#ACTION_STORE_BULK_SRC", ")", "#ACTION_BULK_SUM"}, 60 },
+        { "ПервичноеАрифм", {"min", "(", "ID", "#ACTION_STORE_BULK_SRC", ")", "#ACTION_BULK_MIN"}, 61 },
+        { "ПервичноеАрифм", {"max", "(", "ID", "#ACTION_STORE_BULK_SRC", ")", "#ACTION_BULK_MAX"}, 62 },
+        // Условие if/while: то же, что ЛогВыраж, но результат не вычисляется в 0/1 —
+        // #ACTION_PROG1 переходит по нему сразу.
+        { "Условие", {"#ACTION_LOGIC_BEGIN", "ЛогИЛИ_Терм", "ЛогИЛИ_Прод"}, 63 }
     };
 
     ll_parse_table["Программа"]["int"] = 0;
@@ -278,6 +338,12 @@ void Parser::initialize_grammar_and_table() {
     ll_parse_table["ЛогВыраж"]["NUMBER"] = 38;
     ll_parse_table["ЛогВыраж"]["~"] = 38;
 
+    ll_parse_table["Условие"]["!"] = 63;
+    ll_parse_table["Условие"]["("] = 63;
+    ll_parse_table["Условие"]["ID"] = 63;
+    ll_parse_table["Условие"]["NUMBER"] = 63;
+    ll_parse_table["Условие"]["~"] = 63;
+
     ll_parse_table["ЛогИЛИ_Прод"]["|"] = 39;
     ll_parse_table["ЛогИЛИ_Прод"][")"] = 40;
     ll_parse_table["ЛогИЛИ_Прод"][";"] = 40;
@@ -326,81 +392,172 @@ void Parser::initialize_grammar_and_table() {
     ll_parse_table["ОператорСравнения"]["=="] = 52;
 
     ll_parse_table["ДоступКПеременнойДляRead"]["ID"] = 53;
+
+    for (size_t k = 0; k < BULK_STATEMENTS.size(); ++k) {
+        const std::string& kw = BULK_STATEMENTS[k];
+        ll_parse_table["Программа"][kw] = 0;
+        ll_parse_table["СписокОператоров"][kw] = 1;
+        ll_parse_table["Оператор"][kw] = 54 + static_cast<int>(k);
+        ll_parse_table["ПрограммаВнутриБлока"][kw] = 9;
+        ll_parse_table["Альтернатива"][kw] = 18;
+    }
+    for (size_t k = 0; k < BULK_REDUCTIONS.size(); ++k) {
+        const std::string& kw = BULK_REDUCTIONS[k];
+        ll_parse_table["СписокИниц"][kw] = 19;
+        ll_parse_table["АрифмВыраж"][kw] = 23;
+        ll_parse_table["Терм"][kw] = 27;
+        ll_parse_table["Фактор"][kw] = 32;
+        ll_parse_table["ПервичноеАрифм"][kw] = 60 + static_cast<int>(k);
+        ll_parse_table["ЛогВыраж"][kw] = 38;
+        ll_parse_table["Условие"][kw] = 63;
+        ll_parse_table["ЛогИЛИ_Терм"][kw] = 41;
+        ll_parse_table["ЛогИ_Терм"][kw] = 45;
+        ll_parse_table["СравнениеИлиПервичноеЛог"][kw] = 46;
+    }
 }
 
-std::vector<OPS> Parser::parse(const std::vector<Token>& tokens) {
+// Нумерует символы грамматики и строит плотную таблицу разбора: на каждом шаге
+// разбора символ и правило выбираются по номерам, без сравнения строк.
+void Parser::number_symbols(ParserTables& tables) {
+    auto add_symbol = [&tables](const std::string& name) {
+        auto inserted = tables.symbol_ids.emplace(name, static_cast<int>(tables.symbols.size()));
+        if (inserted.second) {
+            tables.symbols.push_back(name);
+            ParserTables::SymbolKind kind = ParserTables::SymbolKind::TERMINAL;
+            if (tables.ll_parse_table.count(name)) kind = ParserTables::SymbolKind::NONTERMINAL;
+            else if (name.rfind("#ACTION", 0) == 0) kind = ParserTables::SymbolKind::ACTION;
+            tables.symbol_kinds.push_back(kind);
+        }
+        return inserted.first->second;
+    };
+
+    tables.start_symbol = add_symbol(START_SYMBOL);
+    tables.end_symbol = add_symbol(END_SYMBOL);
+    tables.id_symbol = add_symbol("ID");
+    tables.number_symbol = add_symbol("NUMBER");
+    tables.id_or_number_symbol = add_symbol("IDorNUMBER");
+    for (const Rule& rule : tables.grammar_rules) {
+        add_symbol(rule.lhs);
+        std::vector<int> rhs;
+        for (const std::string& symbol : rule.rhs) {
+            if (!symbol.empty()) rhs.push_back(add_symbol(symbol));
+        }
+        tables.rule_symbols.push_back(rhs);
+    }
+    for (const auto& row : tables.ll_parse_table) {
+        add_symbol(row.first);
+        for (const auto& cell : row.second) add_symbol(cell.first);
+    }
+
+    const size_t count = tables.symbols.size();
+    tables.parse_table.assign(count * count, -1);
+    for (const auto& row : tables.ll_parse_table) {
+        const size_t nonterminal = static_cast<size_t>(tables.symbol_ids.at(row.first));
+        for (const auto& cell : row.second) {
+            tables.parse_table[nonterminal * count + static_cast<size_t>(tables.symbol_ids.at(cell.first))] = cell.second;
+        }
+    }
+}
+
+std::vector<OPS> Parser::parse(const std::vector<Token>& tokens, const SourceLines& lines) {
     if (tokens.empty()) {
         throw std::runtime_error("Syntax error at line 1, position 1: empty token list");
     }
-    tokens_list = tokens;
+    tokens_list = &tokens;
+    source_lines = &lines;
     current_token_idx = 0;
     ops_list.clear();
     while (!parse_stack.empty()) parse_stack.pop();
     while (!label_stack.empty()) label_stack.pop();
+    while (!logic_stack.empty()) logic_stack.pop();
+    linked_jumps.clear();
     declared_arrays_set.clear();
     id_for_actions.clear();
     number_for_actions.clear();
     id_for_lhs.clear();
     stored_comparison_operator.clear();
     saved_array_id.clear();
+    bulk_src_id.clear();
+    bulk_operand_start = 0;
     current_initializer_count = 0;
     is_array_access = false;
 
-    parse_stack.push("EOF");
-    parse_stack.push("Программа");
+    input_symbols.resize(tokens.size());
+    for (size_t k = 0; k < tokens.size(); ++k) {
+        const Token& token = tokens[k];
+        InputSymbol& input = input_symbols[k];
+        input.word_class = token.type == "ID" ? tables.id_symbol : token.type == "NUMBER" ? tables.number_symbol : -1;
+        if (input.word_class >= 0 && !is_builtin_call(k)) {
+            input.terminal = input.word_class;
+            continue;
+        }
+        auto terminal = tables.symbol_ids.find(get_input_terminal_string(k));
+        input.terminal = terminal != tables.symbol_ids.end() ? terminal->second : -1;
+    }
+
+    parse_stack.push(tables.end_symbol);
+    parse_stack.push(tables.start_symbol);
 
     if (!silent_mode_active) {
-        std::cout << "Starting LL(1) parsing with " << tokens_list.size() << " tokens\n";
+        *out << "Starting LL(1) parsing with " << tokens_list->size() << " tokens\n";
     }
 
+    const size_t symbol_count = tables.symbols.size();
     while (!parse_stack.empty()) {
-        std::string stack_top_symbol = parse_stack.top();
-        Token current_token = (current_token_idx < tokens_list.size()) ? tokens_list[current_token_idx] : Token("EOF", "", 0, 0);
-        std::string current_input_terminal_str = get_current_input_terminal_string(current_token);
+        const int stack_top = parse_stack.top();
+        const std::string& stack_top_symbol = tables.symbols[stack_top];
+        const bool at_end = current_token_idx >= tokens_list->size();
+        const Token& current_token = at_end ? END_TOKEN : (*tokens_list)[current_token_idx];
+        const int current_terminal = at_end ? tables.end_symbol : input_symbols[current_token_idx].terminal;
 
         if (!silent_mode_active) {
-            std::cout << "Stack top: " << stack_top_symbol << ", Current token: " << current_input_terminal_str << " ('" << current_token.value << "')\n";
+            *out << "Stack top: " << stack_top_symbol << ", Current token: " << get_input_terminal_string(current_token_idx)
+                << " ('" << current_token.value << "')\n";
         }
 
-        if (stack_top_symbol.rfind("#ACTION", 0) == 0) {
+        const ParserTables::SymbolKind kind = tables.symbol_kinds[stack_top];
+        if (kind == ParserTables::SymbolKind::ACTION) {
             parse_stack.pop();
+            STATS_INC(SEMANTIC_ACTIONS);
             execute_action(stack_top_symbol);
         }
-        else if (ll_parse_table.find(stack_top_symbol) == ll_parse_table.end()) {
+        else if (kind == ParserTables::SymbolKind::TERMINAL) {
             parse_stack.pop();
-            if (!match_and_advance(stack_top_symbol)) {
+            if (!match_and_advance(stack_top)) {
                 std::stringstream ss;
-                ss << "Syntax error at line " << current_token.line << ", position " << current_token.pos
+                ss << "Syntax error at line " << line_of(current_token) << ", position " << column_of(current_token)
                     << ": expected '" << stack_top_symbol << "' but found '" << current_token.value << "'";
                 throw std::runtime_error(ss.str());
             }
         }
         else {
-            auto& map_for_nonterminal = ll_parse_table[stack_top_symbol];
-            if (map_for_nonterminal.find(current_input_terminal_str) != map_for_nonterminal.end()) {
-                int rule_idx = map_for_nonterminal[current_input_terminal_str];
-                const auto& rule = grammar_rules[rule_idx];
+            int rule_idx = current_terminal >= 0 ? tables.parse_table[static_cast<size_t>(stack_top) * symbol_count + static_cast<size_t>(current_terminal)] : -1;
+            if (rule_idx >= 0) {
+                const auto& rule = tables.grammar_rules[rule_idx];
                 parse_stack.pop();
+                STATS_INC(RULES_APPLIED);
 
                 if (!silent_mode_active) {
-                    std::cout << "Applying rule " << rule.id << ": " << rule.lhs << " -> ";
-                    for (const auto& sym : rule.rhs) std::cout << sym << " ";
-                    std::cout << "\n";
+                    *out << "Applying rule " << rule.id << ": " << rule.lhs << " -> ";
+                    for (const auto& sym : rule.rhs) *out << sym << " ";
+                    *out << "\n";
                 }
 
-                for (auto it = rule.rhs.rbegin(); it != rule.rhs.rend(); ++it) {
-                    if (!it->empty()) {
-                        parse_stack.push(*it);
-                    }
+                const std::vector<int>& rhs = tables.rule_symbols[rule_idx];
+                for (auto it = rhs.rbegin(); it != rhs.rend(); ++it) {
+                    parse_stack.push(*it);
                 }
             }
             else {
+                // Имена массовых операций для лексера — обычные идентификаторы, и на их месте
+                // допустим ID, который уже есть в списке: отдельно их не перечисляем.
                 std::string expected_terminals_msg = " Expected: ";
-                for (const auto& pair_item : map_for_nonterminal) {
+                for (const auto& pair_item : tables.ll_parse_table.at(stack_top_symbol)) {
+                    if (is_bulk_operation_name(pair_item.first)) continue;
                     expected_terminals_msg += pair_item.first + " ";
                 }
                 std::stringstream ss;
-                ss << "Syntax error at line " << current_token.line << ", position " << current_token.pos
+                ss << "Syntax error at line " << line_of(current_token) << ", position " << column_of(current_token)
                     << ": no rule for nonterminal '" << stack_top_symbol << "' and token '" << current_token.value << "'."
                     << expected_terminals_msg;
                 throw std::runtime_error(ss.str());
@@ -408,18 +565,18 @@ std::vector<OPS> Parser::parse(const std::vector<Token>& tokens) {
         }
     }
 
-    if (current_token_idx < tokens_list.size() && tokens_list[current_token_idx].type != "EOF") {
+    if (current_token_idx < tokens_list->size() && (*tokens_list)[current_token_idx].type != "EOF") {
         std::stringstream ss;
-        ss << "Syntax error at line " << tokens_list[current_token_idx].line << ", position " << tokens_list[current_token_idx].pos
-            << ": unexpected token '" << tokens_list[current_token_idx].value << "'";
+        ss << "Syntax error at line " << line_of((*tokens_list)[current_token_idx]) << ", position " << column_of((*tokens_list)[current_token_idx])
+            << ": unexpected token '" << (*tokens_list)[current_token_idx].value << "'";
         throw std::runtime_error(ss.str());
     }
 
     if (!silent_mode_active) {
-        std::cout << "Parsing completed successfully.\n";
-        std::cout << "OPS generated successfully (" << ops_list.size() << " operations):\n";
+        *out << "Parsing completed successfully.\n";
+        *out << "OPS generated successfully (" << ops_list.size() << " operations):\n";
         for (size_t i = 0; i < ops_list.size(); ++i) {
-            std::cout << i << ": " << ops_list[i].operation << (ops_list[i].operand.empty() ? "" : " " + ops_list[i].operand) << "\n";
+            *out << i << ": " << ops_list[i].operation << (ops_list[i].operand.empty() ? "" : " " + ops_list[i].operand) << "\n";
         }
     }
 
@@ -428,12 +585,10 @@ std::vector<OPS> Parser::parse(const std::vector<Token>& tokens) {
 
 void Parser::execute_action(const std::string& action_symbol) {
     // Получаем текущий или предыдущий токен для указания строки и позиции в ошибках
-    const Token& token = (current_token_idx > 0 && current_token_idx <= tokens_list.size())
-        ? tokens_list[current_token_idx - 1]
-        : (current_token_idx < tokens_list.size() ? tokens_list[current_token_idx] : Token("EOF", "", 0, 0));
+    const Token& token = get_action_token();
 
     if (!silent_mode_active) {
-        std::cout << "Executing action: " << action_symbol << ", id_for_actions: '" << id_for_actions
+        *out << "Executing action: " << action_symbol << ", id_for_actions: '" << id_for_actions
             << "', number_for_actions: '" << number_for_actions << "', is_array_access: '" << is_array_access
             << "', saved_array_id: '" << saved_array_id << "'\n";
     }
@@ -441,11 +596,11 @@ void Parser::execute_action(const std::string& action_symbol) {
     if (action_symbol == "#ACTION_STORE_ID") {
         if (id_for_actions.empty()) {
             std::stringstream ss;
-            ss << "Semantic error at line " << token.line << ", position " << token.pos
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                 << ": no identifier provided for variable or array access";
             throw std::runtime_error(ss.str());
         }
-        if (current_token_idx < tokens_list.size() && tokens_list[current_token_idx].value == "[") {
+        if (current_token_idx < tokens_list->size() && (*tokens_list)[current_token_idx].value == "[") {
             saved_array_id = id_for_actions;
             id_for_actions.clear();
         }
@@ -453,11 +608,11 @@ void Parser::execute_action(const std::string& action_symbol) {
     else if (action_symbol == "#ACTION_STORE_ID_FOR_LHS") {
         if (id_for_actions.empty()) {
             std::stringstream ss;
-            ss << "Semantic error at line " << token.line << ", position " << token.pos
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                 << ": no identifier provided for left-hand side";
             throw std::runtime_error(ss.str());
         }
-        if (current_token_idx < tokens_list.size() && tokens_list[current_token_idx].value == "[") {
+        if (current_token_idx < tokens_list->size() && (*tokens_list)[current_token_idx].value == "[") {
             saved_array_id = id_for_actions;
         }
         id_for_lhs = id_for_actions;
@@ -465,7 +620,7 @@ void Parser::execute_action(const std::string& action_symbol) {
     else if (action_symbol == "#ACTION_CHECK_VAR_EXISTS") {
         if (!is_variable_declared(id_for_lhs)) {
             std::stringstream ss;
-            ss << "Semantic error at line " << token.line << ", position " << token.pos
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                 << ": undeclared variable or array '" << id_for_lhs << "'";
             throw std::runtime_error(ss.str());
         }
@@ -473,7 +628,7 @@ void Parser::execute_action(const std::string& action_symbol) {
     else if (action_symbol == "#ACTION_PROCESS_NUMBER") {
         if (number_for_actions.empty()) {
             std::stringstream ss;
-            ss << "Semantic error at line " << token.line << ", position " << token.pos
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                 << ": no number provided for numeric expression";
             throw std::runtime_error(ss.str());
         }
@@ -507,18 +662,44 @@ void Parser::execute_action(const std::string& action_symbol) {
     else if (action_symbol == "#ACTION_GEN_COMPARE_OP") {
         if (stored_comparison_operator.empty()) {
             std::stringstream ss;
-            ss << "Semantic error at line " << token.line << ", position " << token.pos
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                 << ": no comparison operator set for comparison operation";
             throw std::runtime_error(ss.str());
         }
         add_ops_instruction(stored_comparison_operator);
         stored_comparison_operator.clear();
     }
-    else if (action_symbol == "#ACTION_GEN_AND") {
-        add_ops_instruction("&");
+    else if (action_symbol == "#ACTION_LOGIC_BEGIN") {
+        logic_stack.push(LogicJumps());
+    }
+    else if (action_symbol == "#ACTION_AND_SKIP") {
+        // Левый операнд & ложен — правый не вычисляется.
+        top_logic_jumps().false_jumps.push_back(ops_list.size());
+        add_ops_instruction("jf", "");
     }
-    else if (action_symbol == "#ACTION_GEN_OR") {
-        add_ops_instruction("|");
+    else if (action_symbol == "#ACTION_OR_SKIP") {
+        // Левый операнд | истинен — правый не вычисляется. Ложная цепочка & слева
+        // продолжается правым операндом.
+        LogicJumps& jumps = top_logic_jumps();
+        jumps.true_jumps.push_back(ops_list.size());
+        add_ops_instruction("jt", "");
+        for (size_t p : jumps.false_jumps) set_jump_target(p, ops_list.size());
+        jumps.false_jumps.clear();
+    }
+    else if (action_symbol == "#ACTION_LOGIC_VALUE") {
+        LogicJumps jumps = pop_logic_jumps();
+        if (!jumps.false_jumps.empty() || !jumps.true_jumps.empty()) {
+            // <последний операнд> jf F; T: 1; j E; F: 0; E:
+            jumps.false_jumps.push_back(ops_list.size());
+            add_ops_instruction("jf", "");
+            for (size_t p : jumps.true_jumps) set_jump_target(p, ops_list.size());
+            add_ops_instruction("", "1");
+            size_t end_jump = ops_list.size();
+            add_ops_instruction("j", "");
+            for (size_t p : jumps.false_jumps) set_jump_target(p, ops_list.size());
+            add_ops_instruction("", "0");
+            set_jump_target(end_jump, ops_list.size());
+        }
     }
     else if (action_symbol == "#ACTION_GEN_NOT") {
         add_ops_instruction("!");
@@ -526,7 +707,7 @@ void Parser::execute_action(const std::string& action_symbol) {
     else if (action_symbol == "#ACTION_ASSIGN_VAR") {
         if (!is_variable_declared(id_for_lhs)) {
             std::stringstream ss;
-            ss << "Semantic error at line " << token.line << ", position " << token.pos
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                 << ": undeclared variable '" << id_for_lhs << "' in assignment";
             throw std::runtime_error(ss.str());
         }
@@ -538,7 +719,7 @@ void Parser::execute_action(const std::string& action_symbol) {
         if (!id_for_actions.empty()) {
             if (!is_variable_declared(id_for_actions)) {
                 std::stringstream ss;
-                ss << "Semantic error at line " << token.line << ", position " << token.pos
+                ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                     << ": undeclared variable '" << id_for_actions << "' used as array size";
                 throw std::runtime_error(ss.str());
             }
@@ -551,7 +732,7 @@ void Parser::execute_action(const std::string& action_symbol) {
         }
         else {
             std::stringstream ss;
-            ss << "Semantic error at line " << token.line << ", position " << token.pos
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                 << ": no identifier or number provided for array size for '" << id_for_lhs << "'";
             throw std::runtime_error(ss.str());
         }
@@ -559,7 +740,7 @@ void Parser::execute_action(const std::string& action_symbol) {
     else if (action_symbol == "#ACTION_ALLOC_ARRAY") {
         if (is_variable_declared(id_for_lhs)) {
             std::stringstream ss;
-            ss << "Semantic error at line " << token.line << ", position " << token.pos
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                 << ": array or variable '" << id_for_lhs << "' already declared";
             throw std::runtime_error(ss.str());
         }
@@ -570,7 +751,7 @@ void Parser::execute_action(const std::string& action_symbol) {
     else if (action_symbol == "#ACTION_SET_ARRAY_ACCESS") {
         if (saved_array_id.empty()) {
             std::stringstream ss;
-            ss << "Semantic error at line " << token.line << ", position " << token.pos
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                 << ": no array identifier provided for array access";
             throw std::runtime_error(ss.str());
         }
@@ -581,13 +762,13 @@ void Parser::execute_action(const std::string& action_symbol) {
     else if (action_symbol == "#ACTION_VAR_OR_ARRAY_GET") {
         if (id_for_actions.empty()) {
             std::stringstream ss;
-            ss << "Semantic error at line " << token.line << ", position " << token.pos
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                 << ": no identifier provided for variable or array access";
             throw std::runtime_error(ss.str());
         }
         if (!is_variable_declared(id_for_actions)) {
             std::stringstream ss;
-            ss << "Semantic error at line " << token.line << ", position " << token.pos
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                 << ": undeclared variable or array '" << id_for_actions << "' in expression";
             throw std::runtime_error(ss.str());
         }
@@ -606,7 +787,7 @@ void Parser::execute_action(const std::string& action_symbol) {
     else if (action_symbol == "#ACTION_ARRAY_SET") {
         if (!is_variable_declared(id_for_lhs)) {
             std::stringstream ss;
-            ss << "Semantic error at line " << token.line << ", position " << token.pos
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                 << ": undeclared array '" << id_for_lhs << "' in array set operation";
             throw std::runtime_error(ss.str());
         }
@@ -617,7 +798,7 @@ void Parser::execute_action(const std::string& action_symbol) {
     else if (action_symbol == "#ACTION_READ_VAR_OR_ARRAY") {
         if (!is_variable_declared(id_for_lhs)) {
             std::stringstream ss;
-            ss << "Semantic error at line " << token.line << ", position " << token.pos
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                 << ": undeclared variable or array '" << id_for_lhs << "' in read operation";
             throw std::runtime_error(ss.str());
         }
@@ -636,7 +817,7 @@ void Parser::execute_action(const std::string& action_symbol) {
     else if (action_symbol == "#ACTION_DECL_SIMPLE") {
         if (is_variable_declared(id_for_lhs)) {
             std::stringstream ss;
-            ss << "Semantic error at line " << token.line << ", position " << token.pos
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                 << ": variable or array '" << id_for_lhs << "' already declared";
             throw std::runtime_error(ss.str());
         }
@@ -646,7 +827,7 @@ void Parser::execute_action(const std::string& action_symbol) {
     else if (action_symbol == "#ACTION_DECL_INIT") {
         if (is_variable_declared(id_for_lhs)) {
             std::stringstream ss;
-            ss << "Semantic error at line " << token.line << ", position " << token.pos
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                 << ": variable or array '" << id_for_lhs << "' already declared";
             throw std::runtime_error(ss.str());
         }
@@ -664,13 +845,18 @@ void Parser::execute_action(const std::string& action_symbol) {
         add_ops_instruction("init_array", std::to_string(current_initializer_count));
     }
     else if (action_symbol == "#ACTION_PROG1") {
-        push_label_ops_stack(ops_list.size());
+        // Ложные переходы условия получат адрес вместе с этим jf, истинные ведут в тело.
+        LogicJumps jumps = pop_logic_jumps();
+        size_t jf_pos = ops_list.size();
+        push_label_ops_stack(jf_pos);
         add_ops_instruction("jf", "");
+        if (!jumps.false_jumps.empty()) linked_jumps[jf_pos] = jumps.false_jumps;
+        for (size_t p : jumps.true_jumps) set_jump_target(p, ops_list.size());
     }
     else if (action_symbol == "#ACTION_PROG2") {
         if (label_stack.empty()) {
             std::stringstream ss;
-            ss << "Semantic error at line " << token.line << ", position " << token.pos
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                 << ": label stack underflow in else branch";
             throw std::runtime_error(ss.str());
         }
@@ -691,7 +877,7 @@ void Parser::execute_action(const std::string& action_symbol) {
     else if (action_symbol == "#ACTION_PROG5") {
         if (label_stack.size() < 2) {
             std::stringstream ss;
-            ss << "Semantic error at line " << token.line << ", position " << token.pos
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
                 << ": label stack underflow in while loop";
             throw std::runtime_error(ss.str());
         }
@@ -700,49 +886,112 @@ void Parser::execute_action(const std::string& action_symbol) {
         add_ops_instruction("j", std::to_string(loop_start_pos));
         set_jump_target(jf_target_pos, ops_list.size());
     }
+    else if (action_symbol == "#ACTION_STORE_BULK_SRC") {
+        if (id_for_actions.empty()) {
+            std::stringstream ss;
+            ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
+                << ": no array identifier provided for bulk operation";
+            throw std::runtime_error(ss.str());
+        }
+        bulk_src_id = id_for_actions;
+        id_for_actions.clear();
+    }
+    else if (action_symbol == "#ACTION_BULK_OPERAND_START") {
+        bulk_operand_start = ops_list.size();
+    }
+    else if (action_symbol == "#ACTION_BULK_FILL") {
+        check_bulk_array(id_for_lhs, token);
+        add_ops_instruction("array_fill", id_for_lhs);
+        id_for_lhs.clear();
+    }
+    else if (action_symbol == "#ACTION_BULK_COPY") {
+        check_bulk_array(id_for_lhs, token);
+        check_bulk_array(bulk_src_id, token);
+        add_ops_instruction("array_copy", id_for_lhs + "," + bulk_src_id);
+        id_for_lhs.clear();
+        bulk_src_id.clear();
+    }
+    else if (action_symbol == "#ACTION_BULK_ADD" || action_symbol == "#ACTION_BULK_SUB" || action_symbol == "#ACTION_BULK_MUL") {
+        std::string kind = action_symbol == "#ACTION_BULK_ADD" ? "add" : (action_symbol == "#ACTION_BULK_SUB" ? "sub" : "mul");
+        check_bulk_array(id_for_lhs, token);
+        // Второй операнд разбирается как АрифмВыраж; если он свёлся к одному имени массива,
+        // это поэлементная операция над двумя массивами, иначе — с вычисленным скаляром.
+        if (ops_list.size() == bulk_operand_start + 1 && ops_list.back().operation.empty()
+            && declared_arrays_set.count(ops_list.back().operand)) {
+            std::string src = ops_list.back().operand;
+            ops_list.pop_back();
+            add_ops_instruction("array_" + kind + "_array", id_for_lhs + "," + src);
+        }
+        else {
+            add_ops_instruction("array_" + kind, id_for_lhs);
+        }
+        id_for_lhs.clear();
+    }
+    else if (action_symbol == "#ACTION_BULK_SORT") {
+        check_bulk_array(id_for_lhs, token);
+        add_ops_instruction("array_sort", id_for_lhs);
+        id_for_lhs.clear();
+    }
+    else if (action_symbol == "#ACTION_BULK_SUM" || action_symbol == "#ACTION_BULK_MIN" || action_symbol == "#ACTION_BULK_MAX") {
+        check_bulk_array(bulk_src_id, token);
+        add_ops_instruction(action_symbol == "#ACTION_BULK_SUM" ? "array_sum" : (action_symbol == "#ACTION_BULK_MIN" ? "array_min" : "array_max"), bulk_src_id);
+        bulk_src_id.clear();
+    }
     else {
         std::stringstream ss;
-        ss << "Semantic error at line " << token.line << ", position " << token.pos
+        ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
             << ": unknown semantic action '" << action_symbol << "'";
         throw std::runtime_error(ss.str());
     }
 }
 
 void Parser::add_ops_instruction(const std::string& op, const std::string& arg) {
-    const Token& token = (current_token_idx > 0 && current_token_idx <= tokens_list.size())
-        ? tokens_list[current_token_idx - 1]
-        : (current_token_idx < tokens_list.size() ? tokens_list[current_token_idx] : Token("EOF", "", 0, 0));
+    const Token& token = get_action_token();
 
     if (op.empty() && arg.empty()) {
         std::stringstream ss;
-        ss << "Semantic error at line " << token.line << ", position " << token.pos
+        ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
             << ": attempt to add empty OPS instruction";
         throw std::runtime_error(ss.str());
     }
-    if (!arg.empty() && !isdigit(arg[0]) && op != "alloc_array" && op != "init_array" && !is_variable_declared(arg)) {
+    if (!arg.empty() && !isdigit(arg[0]) && op != "alloc_array" && op != "init_array" && !is_array_pair_operation(op) && !is_variable_declared(arg)) {
         std::stringstream ss;
-        ss << "Semantic error at line " << token.line << ", position " << token.pos
+        ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
             << ": undeclared variable or array '" << arg << "' in OPS instruction";
         throw std::runtime_error(ss.str());
     }
-    ops_list.emplace_back(op, arg);
+    ops_list.emplace_back(op, arg, line_of(token));
+    STATS_INC(OPS_EMITTED);
     if (!silent_mode_active) {
-        std::cout << "Added OPS: " << op << (arg.empty() ? "" : " " + arg) << "\n";
+        *out << "Added OPS: " << op << (arg.empty() ? "" : " " + arg) << "\n";
     }
 }
 
+void Parser::check_bulk_array(const std::string& name, const Token& token) const {
+    if (declared_arrays_set.count(name)) {
+        return;
+    }
+    std::stringstream ss;
+    ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token);
+    if (is_variable_declared(name)) {
+        ss << ": '" << name << "' is not an array in bulk operation";
+    }
+    else {
+        ss << ": undeclared array '" << name << "' in bulk operation";
+    }
+    throw std::runtime_error(ss.str());
+}
+
 void Parser::push_label_ops_stack(size_t p) {
     label_stack.push(p);
 }
 
 size_t Parser::pop_label_ops_stack() {
-    const Token& token = (current_token_idx > 0 && current_token_idx <= tokens_list.size())
-        ? tokens_list[current_token_idx - 1]
-        : (current_token_idx < tokens_list.size() ? tokens_list[current_token_idx] : Token("EOF", "", 0, 0));
+    const Token& token = get_action_token();
 
     if (label_stack.empty()) {
         std::stringstream ss;
-        ss << "Semantic error at line " << token.line << ", position " << token.pos
+        ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
             << ": label stack is empty";
         throw std::runtime_error(ss.str());
     }
@@ -752,24 +1001,45 @@ size_t Parser::pop_label_ops_stack() {
 }
 
 void Parser::set_jump_target(size_t p, size_t t) {
-    const Token& token = (current_token_idx > 0 && current_token_idx <= tokens_list.size())
-        ? tokens_list[current_token_idx - 1]
-        : (current_token_idx < tokens_list.size() ? tokens_list[current_token_idx] : Token("EOF", "", 0, 0));
+    const Token& token = get_action_token();
 
     if (p >= ops_list.size()) {
         std::stringstream ss;
-        ss << "Semantic error at line " << token.line << ", position " << token.pos
+        ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
             << ": invalid jump label position " << p;
         throw std::runtime_error(ss.str());
     }
-    if (ops_list[p].operation != "jf" && ops_list[p].operation != "j") {
+    if (ops_list[p].operation != "jf" && ops_list[p].operation != "jt" && ops_list[p].operation != "j") {
         std::stringstream ss;
-        ss << "Semantic error at line " << token.line << ", position " << token.pos
+        ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
             << ": attempt to set jump target on non-jump instruction at position " << p;
         throw std::runtime_error(ss.str());
     }
     ops_list[p].operand = std::to_string(t);
     if (!silent_mode_active) {
-        std::cout << "Set target " << p << "->" << t << "\n";
+        *out << "Set target " << p << "->" << t << "\n";
+    }
+    auto linked = linked_jumps.find(p);
+    if (linked != linked_jumps.end()) {
+        std::vector<size_t> jumps = std::move(linked->second);
+        linked_jumps.erase(linked);
+        for (size_t q : jumps) set_jump_target(q, t);
+    }
+}
+
+Parser::LogicJumps& Parser::top_logic_jumps() {
+    if (logic_stack.empty()) {
+        const Token& token = get_action_token();
+        std::stringstream ss;
+        ss << "Semantic error at line " << line_of(token) << ", position " << column_of(token)
+            << ": logical operator outside of logical expression";
+        throw std::runtime_error(ss.str());
     }
+    return logic_stack.top();
+}
+
+Parser::LogicJumps Parser::pop_logic_jumps() {
+    LogicJumps jumps = top_logic_jumps();
+    logic_stack.pop();
+    return jumps;
 }
\ No newline at end of file
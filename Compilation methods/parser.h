@@ -9,6 +9,7 @@
 #include <stack>
 #include <map>
 #include <set>
+#include <unordered_map>
 
 struct Rule {
     std::string lhs;
@@ -16,16 +17,50 @@ struct Rule {
     int id;
 };
 
+struct ParserTables {
+    std::vector<Rule> grammar_rules;
+    std::map<std::string, std::map<std::string, int>> ll_parse_table;
+
+    // Те же таблицы с символами-номерами: по ним идёт разбор, строки нужны только
+    // для подробного вывода, сообщений об ошибках и имён действий.
+    enum class SymbolKind : unsigned char { TERMINAL, NONTERMINAL, ACTION };
+    std::vector<std::string> symbols;                 // имя символа по номеру
+    std::vector<SymbolKind> symbol_kinds;
+    std::unordered_map<std::string, int> symbol_ids;
+    std::vector<std::vector<int>> rule_symbols;       // правые части правил без пустых символов
+    std::vector<int> parse_table;                     // [нетерминал * symbols.size() + терминал] -> правило или -1
+    int start_symbol;
+    int end_symbol;
+    int id_symbol;
+    int number_symbol;
+    int id_or_number_symbol;
+};
+
 class Parser {
 private:
     SymbolTable& sym_table;
-    std::vector<Token> tokens_list;
+    const std::vector<Token>* tokens_list; // лексемы разбираемой программы (на время parse)
+    const SourceLines* source_lines;
     std::vector<OPS> ops_list;
-    std::stack<std::string> parse_stack;
+    std::stack<int> parse_stack; // номера символов из get_tables().symbols
+
+    // Терминал каждой лексемы и её класс (ID, NUMBER или -1) — вычисляются один раз в начале parse.
+    struct InputSymbol {
+        int terminal;
+        int word_class;
+    };
+    std::vector<InputSymbol> input_symbols;
     std::stack<size_t> label_stack;
 
-    std::vector<Rule> grammar_rules;
-    std::map<std::string, std::map<std::string, int>> ll_parse_table;
+    // Переходы сокращённого вычисления & и |, ещё не получившие адрес: по одному
+    // набору на каждое вложенное логическое выражение.
+    struct LogicJumps {
+        std::vector<size_t> false_jumps; // jf: ложен левый операнд текущей цепочки &
+        std::vector<size_t> true_jumps;  // jt: истинен левый операнд |
+    };
+    std::stack<LogicJumps> logic_stack;
+    std::map<size_t, std::vector<size_t>> linked_jumps; // jf условия -> переходы с тем же адресом
+
     std::set<std::string> declared_arrays_set;
 
     std::string id_for_actions;
@@ -33,25 +68,41 @@ private:
     std::string id_for_lhs;
     std::string stored_comparison_operator;
     std::string saved_array_id;
+    std::string bulk_src_id;
+    size_t bulk_operand_start;
     bool is_array_access;
     int current_initializer_count;
     size_t current_token_idx;
     bool silent_mode_active;
+    std::ostream* out;
+    const ParserTables& tables;
 
-    void initialize_grammar_and_table();
+    static const ParserTables& get_tables();
+    static void initialize_grammar_and_table(ParserTables& tables);
+    static void number_symbols(ParserTables& tables);
     void execute_action(const std::string& action_symbol);
-    std::string get_current_input_terminal_string(const Token& token);
-    bool match_and_advance(const std::string& expected_terminal_in_rule);
+    bool is_builtin_call(size_t index) const;
+    const std::string& get_input_terminal_string(size_t index) const;
+    const Token& get_action_token() const;
+    bool match_and_advance(int expected_terminal);
     void add_ops_instruction(const std::string& operation, const std::string& operand = "");
     void push_label_ops_stack(size_t p);
     size_t pop_label_ops_stack();
     void set_jump_target(size_t ops_label_pos, size_t ops_target_address);
+    LogicJumps& top_logic_jumps();
+    LogicJumps pop_logic_jumps();
     bool is_variable_declared(const std::string& name) const;
+    void check_bulk_array(const std::string& name, const Token& token) const;
+    int line_of(const Token& token) const;
+    int column_of(const Token& token) const;
 
 public:
     Parser(SymbolTable& sym_table);
     void set_silent_mode(bool mode);
-    std::vector<OPS> parse(const std::vector<Token>& tokens);
+    void set_output_stream(std::ostream& stream);
+    // lines — индекс строк текста, из которого получены tokens: по нему вычисляются
+    // номера строк ОПС и позиции в сообщениях об ошибках.
+    std::vector<OPS> parse(const std::vector<Token>& tokens, const SourceLines& lines);
 };
 
 #endif  // PARSER_H
\ No newline at end of file
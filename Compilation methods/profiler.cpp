@@ -0,0 +1,277 @@
+#include "profiler.h"
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <mutex>
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+#endif
+
+void ExecutionProfile::reset(size_t instruction_count) {
+    counts.assign(instruction_count, 0);
+    cycles.assign(instruction_count, 0);
+}
+
+static std::vector<std::string> split_lines(const std::string& code) {
+    std::vector<std::string> lines;
+    std::istringstream stream(code);
+    std::string line;
+    while (std::getline(stream, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t first = line.find_first_not_of(" \t");
+        lines.push_back(first == std::string::npos ? "" : line.substr(first));
+    }
+    return lines;
+}
+
+static double percent(uint64_t part, uint64_t total) {
+    return total ? 100.0 * static_cast<double>(part) / static_cast<double>(total) : 0.0;
+}
+
+void print_profile_report(const ExecutionProfile& profile, const BytecodeImage& image,
+    const std::string& code, std::ostream& out, size_t top) {
+    const size_t code_size = image.header().instruction_count;
+    const Opcode* opcodes = image.opcodes();
+    const int32_t* operands = image.operands();
+    const uint32_t* lines = image.lines();
+    std::vector<std::string> source = split_lines(code);
+    auto source_line = [&](uint32_t line) -> std::string {
+        return line >= 1 && line <= source.size() ? source[line - 1] : "";
+    };
+
+    struct LineStats {
+        uint64_t count = 0;  // наибольшее число выполнений инструкции строки
+        uint64_t instructions = 0;
+        uint64_t cycles = 0;
+    };
+    std::map<uint32_t, LineStats> by_line;
+    uint64_t total_instructions = 0;
+    uint64_t total_cycles = 0;
+    for (size_t pc = 0; pc < code_size && pc < profile.counts.size(); ++pc) {
+        LineStats& stats = by_line[lines[pc]];
+        stats.instructions += profile.counts[pc];
+        stats.cycles += profile.cycles[pc];
+        stats.count = std::max(stats.count, profile.counts[pc]);
+        total_instructions += profile.counts[pc];
+        total_cycles += profile.cycles[pc];
+    }
+
+    out << "=== Profile: " << total_instructions << " instructions, " << total_cycles << " cycles ===\n";
+
+    std::vector<std::pair<uint32_t, LineStats>> hot_lines(by_line.begin(), by_line.end());
+    std::stable_sort(hot_lines.begin(), hot_lines.end(), [](const auto& a, const auto& b) {
+        return a.second.cycles > b.second.cycles;
+    });
+    if (hot_lines.size() > top) hot_lines.resize(top);
+    out << "Hot lines:\n";
+    out << std::setw(6) << "line" << std::setw(12) << "executions" << std::setw(14) << "instructions"
+        << std::setw(14) << "cycles" << std::setw(8) << "%" << "  source\n";
+    for (const auto& entry : hot_lines) {
+        if (entry.second.instructions == 0) break;
+        out << std::setw(6) << entry.first << std::setw(12) << entry.second.count << std::setw(14) << entry.second.instructions
+            << std::setw(14) << entry.second.cycles << std::setw(7) << std::fixed << std::setprecision(1)
+            << percent(entry.second.cycles, total_cycles) << "%  " << source_line(entry.first) << "\n";
+        out.unsetf(std::ios::fixed);
+    }
+
+    // Цикл — участок от цели обратного перехода (j или jt перевёрнутого цикла) до самого перехода.
+    struct LoopStats {
+        size_t start;
+        size_t end;
+        uint32_t first_line;
+        uint32_t last_line;
+        uint64_t iterations;
+        uint64_t cycles;
+    };
+    std::vector<LoopStats> loops;
+    for (size_t pc = 0; pc < code_size; ++pc) {
+        Opcode opcode = opcodes[pc];
+        if ((opcode != Opcode::J && opcode != Opcode::JT) || operands[pc] < 0 || static_cast<size_t>(operands[pc]) > pc) continue;
+        LoopStats loop = { static_cast<size_t>(operands[pc]), pc, 0, 0, profile.counts[pc], 0 };
+        for (size_t i = loop.start; i <= loop.end; ++i) {
+            loop.cycles += profile.cycles[i];
+            if (lines[i] == 0) continue;
+            if (loop.first_line == 0 || lines[i] < loop.first_line) loop.first_line = lines[i];
+            loop.last_line = std::max(loop.last_line, lines[i]);
+        }
+        if (loop.iterations) loops.push_back(loop);
+    }
+    std::stable_sort(loops.begin(), loops.end(), [](const LoopStats& a, const LoopStats& b) {
+        return a.cycles > b.cycles;
+    });
+    if (loops.size() > top) loops.resize(top);
+    out << "Hot loops:\n";
+    out << std::setw(12) << "lines" << std::setw(12) << "ops" << std::setw(12) << "iterations"
+        << std::setw(14) << "cycles" << std::setw(8) << "%" << "  header\n";
+    for (const LoopStats& loop : loops) {
+        out << std::setw(12) << (std::to_string(loop.first_line) + "-" + std::to_string(loop.last_line))
+            << std::setw(12) << (std::to_string(loop.start) + "-" + std::to_string(loop.end))
+            << std::setw(12) << loop.iterations << std::setw(14) << loop.cycles << std::setw(7) << std::fixed << std::setprecision(1)
+            << percent(loop.cycles, total_cycles) << "%  " << source_line(loop.first_line) << "\n";
+        out.unsetf(std::ios::fixed);
+    }
+}
+
+SamplingProfiler::SamplingProfiler(const std::atomic<size_t>& pc, size_t instruction_count, unsigned rate_hz)
+    : pc(pc), samples(instruction_count + 1, 0), rate_hz(rate_hz ? rate_hz : 1), running(false)
+#ifdef __linux__
+    , slot(-1), timer()
+#else
+    , stop_requested(false)
+#endif
+{}
+
+SamplingProfiler::~SamplingProfiler() {
+    stop();
+}
+
+const std::vector<uint64_t>& SamplingProfiler::get_samples() const {
+    return samples;
+}
+
+unsigned SamplingProfiler::get_rate() const {
+    return rate_hz;
+}
+
+void SamplingProfiler::record() {
+    size_t current = pc.load(std::memory_order_relaxed);
+    ++samples[std::min(current, samples.size() - 1)];
+}
+
+#ifdef __linux__
+// Обработчик сигнала получает номер ячейки, а не указатель: сигнал, задержавшийся
+// после stop, найдёт пустую ячейку и не обратится к уничтоженному объекту.
+static const int MAX_SAMPLING_PROFILERS = 256;
+static std::atomic<SamplingProfiler*> active_profilers[MAX_SAMPLING_PROFILERS];
+static std::once_flag signal_handler_installed;
+
+void SamplingProfiler::handle_signal(int, siginfo_t* info, void*) {
+    int index = info->si_value.sival_int;
+    if (index < 0 || index >= MAX_SAMPLING_PROFILERS) return;
+    if (SamplingProfiler* profiler = active_profilers[index].load(std::memory_order_acquire)) {
+        profiler->record();
+    }
+}
+
+void SamplingProfiler::start() {
+    if (running) return;
+    std::call_once(signal_handler_installed, [] {
+        struct sigaction action = {};
+        action.sa_sigaction = &SamplingProfiler::handle_signal;
+        action.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGPROF, &action, nullptr) != 0) {
+            throw std::runtime_error("Cannot install SIGPROF handler");
+        }
+    });
+    for (int i = 0; i < MAX_SAMPLING_PROFILERS && slot < 0; ++i) {
+        SamplingProfiler* expected = nullptr;
+        if (active_profilers[i].compare_exchange_strong(expected, this)) slot = i;
+    }
+    if (slot < 0) throw std::runtime_error("Too many sampling profilers");
+
+    // Таймер процессорного времени текущего потока, сигнал — этому же потоку.
+    struct sigevent event = {};
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event.sigev_value.sival_int = slot;
+    event.sigev_notify_thread_id = static_cast<pid_t>(syscall(SYS_gettid));
+    if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &timer) != 0) {
+        active_profilers[slot].store(nullptr);
+        slot = -1;
+        throw std::runtime_error("Cannot create profiling timer");
+    }
+    struct itimerspec spec = {};
+    long interval = 1000000000L / static_cast<long>(rate_hz);
+    spec.it_interval.tv_sec = interval / 1000000000L;
+    spec.it_interval.tv_nsec = interval % 1000000000L;
+    spec.it_value = spec.it_interval;
+    timer_settime(timer, 0, &spec, nullptr);
+    running = true;
+}
+
+void SamplingProfiler::stop() {
+    if (!running) return;
+    timer_delete(timer);
+    active_profilers[slot].store(nullptr);
+    slot = -1;
+    running = false;
+}
+#else
+void SamplingProfiler::start() {
+    if (running) return;
+    stop_requested = false;
+    sampler = std::thread([this] {
+        std::unique_lock<std::mutex> lock(mutex);
+        const auto interval = std::chrono::nanoseconds(1000000000LL / rate_hz);
+        while (!stopped.wait_for(lock, interval, [this] { return stop_requested; })) {
+            record();
+        }
+    });
+    running = true;
+}
+
+void SamplingProfiler::stop() {
+    if (!running) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop_requested = true;
+    }
+    stopped.notify_all();
+    sampler.join();
+    running = false;
+}
+#endif
+
+void print_sample_report(const SamplingProfiler& profiler, const BytecodeImage& image,
+    const std::string& code, std::ostream& out, size_t top) {
+    const std::vector<uint64_t>& samples = profiler.get_samples();
+    const size_t code_size = std::min<size_t>(image.header().instruction_count, samples.size() - 1);
+    const Opcode* opcodes = image.opcodes();
+    const uint32_t* lines = image.lines();
+    std::vector<std::string> source = split_lines(code);
+
+    uint64_t total = 0;
+    for (uint64_t count : samples) total += count;
+    out << "=== Sampling profile: " << total << " samples at " << profiler.get_rate() << " Hz, "
+        << samples.back() << " outside the interpreter loop ===\n";
+
+    std::map<uint32_t, uint64_t> by_line;
+    std::vector<size_t> hot_instructions;
+    for (size_t pc = 0; pc < code_size; ++pc) {
+        if (!samples[pc]) continue;
+        by_line[lines[pc]] += samples[pc];
+        hot_instructions.push_back(pc);
+    }
+    std::vector<std::pair<uint32_t, uint64_t>> hot_lines(by_line.begin(), by_line.end());
+    std::stable_sort(hot_lines.begin(), hot_lines.end(), [](const auto& a, const auto& b) {
+        return a.second > b.second;
+    });
+    if (hot_lines.size() > top) hot_lines.resize(top);
+    out << "Hot lines:\n";
+    out << std::setw(6) << "line" << std::setw(10) << "samples" << std::setw(8) << "%" << "  source\n";
+    for (const auto& entry : hot_lines) {
+        out << std::setw(6) << entry.first << std::setw(10) << entry.second << std::setw(7) << std::fixed << std::setprecision(1)
+            << percent(entry.second, total) << "%  " << (entry.first >= 1 && entry.first <= source.size() ? source[entry.first - 1] : "") << "\n";
+        out.unsetf(std::ios::fixed);
+    }
+
+    std::stable_sort(hot_instructions.begin(), hot_instructions.end(), [&](size_t a, size_t b) {
+        return samples[a] > samples[b];
+    });
+    if (hot_instructions.size() > top) hot_instructions.resize(top);
+    out << "Hot instructions:\n";
+    out << std::setw(6) << "pc" << std::setw(6) << "line" << std::setw(10) << "samples" << std::setw(8) << "%" << "  instruction\n";
+    for (size_t pc : hot_instructions) {
+        std::string text = image.get_operand_text(pc);
+        out << std::setw(6) << pc << std::setw(6) << lines[pc] << std::setw(10) << samples[pc] << std::setw(7) << std::fixed << std::setprecision(1)
+            << percent(samples[pc], total) << "%  " << get_opcode_name(opcodes[pc]) << (text.empty() ? "" : " " + text) << "\n";
+        out.unsetf(std::ios::fixed);
+    }
+}
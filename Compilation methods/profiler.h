@@ -0,0 +1,92 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "bytecode.h"
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <signal.h>
+#include <time.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// Счётчик тактов процессора (на x86 — TSC, иначе наносекунды steady_clock).
+inline uint64_t read_cycle_counter() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Профиль выполнения по инструкциям байткода: сколько раз выполнена инструкция и
+// сколько тактов прошло от её начала до начала следующей.
+struct ExecutionProfile {
+    std::vector<uint64_t> counts;
+    std::vector<uint64_t> cycles;
+
+    void reset(size_t instruction_count);
+};
+
+// Отчёт по строкам исходного текста: самые горячие строки и циклы (обратные
+// переходы j). Номера строк берутся из таблицы строк образа; code может быть
+// пустым (например, при выполнении файла байткода), тогда текст строк не печатается.
+void print_profile_report(const ExecutionProfile& profile, const BytecodeImage& image,
+    const std::string& code, std::ostream& out, size_t top = 10);
+
+// Профилирование выборками для долгих программ: rate_hz раз в секунду процессорного
+// времени потока читается текущий pc интерпретатора (Interpreter::get_current_pc).
+// На Linux выборки берёт обработчик SIGPROF таймера timer_create, привязанного к
+// потоку, который вызвал start (он же должен выполнять программу); на других
+// системах — отдельный поток, просыпающийся с той же частотой.
+class SamplingProfiler {
+public:
+    SamplingProfiler(const std::atomic<size_t>& pc, size_t instruction_count, unsigned rate_hz);
+    ~SamplingProfiler();
+    SamplingProfiler(const SamplingProfiler&) = delete;
+    SamplingProfiler& operator=(const SamplingProfiler&) = delete;
+
+    void start();
+    void stop();
+    // Число выборок по инструкциям; последний элемент — выборки вне цикла интерпретатора.
+    const std::vector<uint64_t>& get_samples() const;
+    unsigned get_rate() const;
+
+private:
+    void record();
+
+    const std::atomic<size_t>& pc;
+    std::vector<uint64_t> samples;
+    unsigned rate_hz;
+    bool running;
+#ifdef __linux__
+    static void handle_signal(int signal, siginfo_t* info, void* context);
+    int slot;
+    timer_t timer;
+#else
+    std::thread sampler;
+    std::mutex mutex;
+    std::condition_variable stopped;
+    bool stop_requested;
+#endif
+};
+
+// Отчёт по выборкам: доли строк и самых частых инструкций.
+void print_sample_report(const SamplingProfiler& profiler, const BytecodeImage& image,
+    const std::string& code, std::ostream& out, size_t top = 10);
+
+#endif // PROFILER_H
@@ -0,0 +1,40 @@
+#include "program.h"
+#include "lexer.h"
+#include "parser.h"
+#include "optimizer.h"
+#include <sstream>
+
+Program::Program(BytecodeImage image) : bytecode(std::move(image)) {}
+
+std::shared_ptr<const Program> Program::compile(const std::string& code, bool optimize) {
+    std::ostringstream discarded;
+    SymbolTable sym_table;
+    sym_table.set_output_stream(discarded);
+    sym_table.set_silent_mode(true);
+
+    Lexer lexer(code);
+    lexer.set_silent_mode(true);
+    std::vector<Token> tokens = lexer.tokenize();
+    SourceLines lines(code);
+
+    Parser parser(sym_table);
+    parser.set_output_stream(discarded);
+    parser.set_silent_mode(true);
+    std::vector<OPS> ops_list = parser.parse(tokens, lines);
+
+    if (optimize) {
+        Optimizer optimizer;
+        optimizer.set_output_stream(discarded);
+        optimizer.set_silent_mode(true);
+        ops_list = optimizer.optimize(ops_list);
+    }
+    return std::make_shared<const Program>(compile_bytecode(ops_list, sym_table));
+}
+
+std::shared_ptr<const Program> Program::load(const std::string& bytecode_file) {
+    return std::make_shared<const Program>(BytecodeImage::map_file(bytecode_file));
+}
+
+const BytecodeImage& Program::image() const {
+    return bytecode;
+}
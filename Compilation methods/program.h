@@ -0,0 +1,36 @@
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include "bytecode.h"
+#include "execution_context.h"
+#include <memory>
+#include <string>
+
+// Скомпилированная программа для встраивания: неизменяемый образ байткода.
+// Компилируется один раз, выполняется сколько угодно раз в ExecutionContext,
+// в том числе одновременно из разных потоков (у каждого потока свой контекст).
+//
+//     auto program = Program::compile(code);
+//     ExecutionContext context(program->image());
+//     context.set_input(...);
+//     context.set_output(...);
+//     context.run();
+//     context.reset();  // перед следующим выполнением
+class Program {
+public:
+    explicit Program(BytecodeImage image);
+
+    // Лексический и синтаксический анализ, оптимизация и перевод в байткод без
+    // вывода; ошибки — std::runtime_error (лексические — его наследник Error из
+    // error.h со строкой и позицией). Таблица символов парсера нужна только на
+    // время компиляции и в программу не входит.
+    static std::shared_ptr<const Program> compile(const std::string& code, bool optimize = true);
+    static std::shared_ptr<const Program> load(const std::string& bytecode_file);
+
+    const BytecodeImage& image() const;
+
+private:
+    BytecodeImage bytecode;
+};
+
+#endif // PROGRAM_H
@@ -0,0 +1,385 @@
+#include "server.h"
+#include "lexer.h"
+#include "parser.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "Ws2_32.lib")
+typedef SOCKET socket_handle;
+static const socket_handle INVALID_HANDLE = INVALID_SOCKET;
+static const int SEND_FLAGS = 0;
+
+static void close_handle(socket_handle handle) {
+    closesocket(handle);
+}
+
+// Прерывает ожидающий accept.
+static void stop_listening(socket_handle handle) {
+    closesocket(handle);
+}
+
+static void remove_socket_file(const std::string& path) {
+    DeleteFileA(path.c_str());
+}
+
+// Winsock нужно инициализировать до первого сокета.
+static bool init_sockets() {
+    static const bool initialized = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return initialized;
+}
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+typedef int socket_handle;
+static const socket_handle INVALID_HANDLE = -1;
+static const int SEND_FLAGS = MSG_NOSIGNAL; // закрытое клиентом соединение не должно завершать сервер
+
+static void close_handle(socket_handle handle) {
+    close(handle);
+}
+
+static void stop_listening(socket_handle handle) {
+    shutdown(handle, SHUT_RDWR);
+}
+
+static void remove_socket_file(const std::string& path) {
+    unlink(path.c_str());
+}
+
+static bool init_sockets() {
+    return true;
+}
+#endif
+
+static bool make_address(const std::string& path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+static socket_handle connect_to(const std::string& path) {
+    sockaddr_un address;
+    if (!init_sockets() || !make_address(path, address)) {
+        return INVALID_HANDLE;
+    }
+    socket_handle handle = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (handle == INVALID_HANDLE) {
+        return INVALID_HANDLE;
+    }
+    if (connect(handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close_handle(handle);
+        return INVALID_HANDLE;
+    }
+    return handle;
+}
+
+// Буферизованное чтение строк заголовков и тел заданной длины.
+class SocketStream {
+public:
+    explicit SocketStream(socket_handle handle) : handle(handle), buffer_pos(0) {}
+
+    bool read_line(std::string& line) {
+        line.clear();
+        while (true) {
+            size_t end = buffer.find('\n', buffer_pos);
+            if (end != std::string::npos) {
+                line.assign(buffer, buffer_pos, end - buffer_pos);
+                buffer_pos = end + 1;
+                return true;
+            }
+            if (!fill()) return false;
+        }
+    }
+
+    bool read_exact(std::string& data, size_t size) {
+        while (buffer.size() - buffer_pos < size) {
+            if (!fill()) return false;
+        }
+        data.assign(buffer, buffer_pos, size);
+        buffer_pos += size;
+        return true;
+    }
+
+    bool write_all(const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            int chunk = static_cast<int>(std::min<size_t>(data.size() - sent, 1 << 20));
+            int result = static_cast<int>(send(handle, data.data() + sent, chunk, SEND_FLAGS));
+            if (result <= 0) return false;
+            sent += static_cast<size_t>(result);
+        }
+        return true;
+    }
+
+private:
+    bool fill() {
+        buffer.erase(0, buffer_pos);
+        buffer_pos = 0;
+        char chunk[4096];
+        int received = static_cast<int>(recv(handle, chunk, sizeof(chunk), 0));
+        if (received <= 0) return false;
+        buffer.append(chunk, static_cast<size_t>(received));
+        return true;
+    }
+
+    socket_handle handle;
+    std::string buffer;
+    size_t buffer_pos;
+};
+
+static void print_latency_summary(const std::string& label, std::vector<double> latencies, std::ostream& out) {
+    if (latencies.empty()) return;
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        size_t rank = static_cast<size_t>(p / 100.0 * static_cast<double>(latencies.size()) + 0.999999);
+        return latencies[std::min(latencies.size(), std::max<size_t>(rank, 1)) - 1];
+    };
+    out << "=== " << label << ": " << latencies.size() << " requests, p50 " << percentile(50) << " us, p90 " << percentile(90)
+        << " us, p99 " << percentile(99) << " us, max " << latencies.back() << " us ===\n";
+}
+
+struct ServerState {
+    socket_handle listener;
+    std::atomic<bool> stopping;
+    std::mutex latency_mutex;
+    std::vector<double> latencies;
+    std::mutex connections_mutex;
+    std::condition_variable connections_closed;
+    size_t open_connections;
+};
+
+// Компиляция и выполнение одного запроса; возвращает текст ответа.
+static std::string run_request(const std::string& name, const std::string& code, const std::string& input_text,
+    std::chrono::steady_clock::time_point start, ServerState& state, const RunOptions& options) {
+    std::istringstream input(input_text);
+    std::ostringstream output;
+    bool success = false;
+    try {
+        success = run_program(name.empty() ? "request" : name, code, options, input, output, output);
+    }
+    catch (const std::exception& e) {
+        output << "Error in " << name << ": " << e.what() << "\n";
+    }
+    catch (...) {
+        output << "Error in " << name << ": unknown error\n";
+    }
+    double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    {
+        std::lock_guard<std::mutex> lock(state.latency_mutex);
+        state.latencies.push_back(micros);
+    }
+    std::string body = output.str();
+    std::ostringstream response;
+    response << (success ? "OK " : "ERROR ") << body.size() << " " << std::fixed << std::setprecision(1) << micros << "\n" << body;
+    return response.str();
+}
+
+// Поток соединения только читает запросы и пишет ответы; сами запросы выполняет пул.
+// Простаивающий клиент не занимает рабочий поток, и пул делится между соединениями
+// по запросам, а не по соединениям.
+static void serve_connection(socket_handle client, ServerState& state, ThreadPool& pool, const RunOptions& options) {
+    SocketStream stream(client);
+    std::string header;
+    while (stream.read_line(header)) {
+        std::istringstream fields(header);
+        std::string verb;
+        fields >> verb;
+        if (verb == "SHUTDOWN") {
+            state.stopping = true;
+            stream.write_all("OK 0 0\n");
+            stop_listening(state.listener);
+            break;
+        }
+        size_t code_size = 0;
+        size_t input_size = 0;
+        if (verb != "RUN" || !(fields >> code_size >> input_size)) {
+            std::string message = "Error: bad request '" + header + "'\n";
+            stream.write_all("ERROR " + std::to_string(message.size()) + " 0\n" + message);
+            break;
+        }
+        std::string name;
+        std::getline(fields >> std::ws, name);
+        std::string code;
+        std::string input_text;
+        if (!stream.read_exact(code, code_size) || !stream.read_exact(input_text, input_size)) {
+            break;
+        }
+
+        // Время на сервере включает ожидание свободного потока пула.
+        auto start = std::chrono::steady_clock::now();
+        std::promise<std::string> response;
+        std::future<std::string> ready = response.get_future();
+        pool.submit([&] {
+            response.set_value(run_request(name, code, input_text, start, state, options));
+        });
+        if (!stream.write_all(ready.get())) {
+            break;
+        }
+    }
+    close_handle(client);
+}
+
+int run_server(const std::string& socket_path, size_t thread_count, const RunOptions& options) {
+    sockaddr_un address;
+    if (!init_sockets() || !make_address(socket_path, address)) {
+        std::cerr << "Error: Cannot use socket path " << socket_path << std::endl;
+        return 1;
+    }
+    ServerState state;
+    state.stopping = false;
+    state.open_connections = 0;
+    state.listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (state.listener == INVALID_HANDLE) {
+        std::cerr << "Error: Cannot create socket" << std::endl;
+        return 1;
+    }
+    remove_socket_file(socket_path);
+    if (bind(state.listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(state.listener, SOMAXCONN) != 0) {
+        std::cerr << "Error: Cannot listen on " << socket_path << std::endl;
+        close_handle(state.listener);
+        return 1;
+    }
+
+    // Таблицы лексера и парсера строятся при первом создании; делаем это до первого запроса.
+    {
+        Lexer warm_lexer("");
+        SymbolTable warm_table;
+        Parser warm_parser(warm_table);
+    }
+
+    std::cout << "=== Server listening on " << socket_path << " ===" << std::endl;
+    {
+        ThreadPool pool(thread_count);
+        while (true) {
+            socket_handle client = accept(state.listener, nullptr, nullptr);
+            if (client == INVALID_HANDLE) {
+                if (state.stopping) break;
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(state.connections_mutex);
+                ++state.open_connections;
+            }
+            std::thread([client, &state, &pool, &options] {
+                serve_connection(client, state, pool, options);
+                // Уведомление под замком: после него run_server может сразу разрушить state.
+                std::lock_guard<std::mutex> lock(state.connections_mutex);
+                --state.open_connections;
+                state.connections_closed.notify_all();
+            }).detach();
+        }
+        // Открытые соединения дообслуживаются; пул нужен им до последнего ответа.
+        std::unique_lock<std::mutex> lock(state.connections_mutex);
+        state.connections_closed.wait(lock, [&state] { return state.open_connections == 0; });
+    }
+#ifndef _WIN32
+    close_handle(state.listener);
+#endif
+    remove_socket_file(socket_path);
+    print_latency_summary("Server stopped", state.latencies, std::cout);
+    return 0;
+}
+
+int run_client(const std::string& socket_path, const std::string& list_file) {
+    std::ifstream list(list_file);
+    if (!list.is_open()) {
+        std::cerr << "Error: Cannot open file " << list_file << std::endl;
+        return 1;
+    }
+    socket_handle server = connect_to(socket_path);
+    if (server == INVALID_HANDLE) {
+        std::cerr << "Error: Cannot connect to " << socket_path << std::endl;
+        return 1;
+    }
+    SocketStream stream(server);
+    std::vector<double> round_trips;
+    std::vector<double> server_times;
+    size_t failed = 0;
+    std::string line;
+    while (std::getline(list, line)) {
+        std::istringstream fields(line);
+        std::string program_file;
+        std::string input_file;
+        if (!(fields >> program_file)) continue;
+        fields >> input_file;
+
+        std::ifstream program(program_file);
+        if (!program.is_open()) {
+            std::cerr << "Error: Cannot open file " << program_file << "\n";
+            ++failed;
+            continue;
+        }
+        std::stringstream code;
+        code << program.rdbuf();
+        std::stringstream input;
+        if (!input_file.empty()) {
+            std::ifstream input_stream(input_file);
+            if (!input_stream.is_open()) {
+                std::cerr << "Error: Cannot open input file " << input_file << "\n";
+                ++failed;
+                continue;
+            }
+            input << input_stream.rdbuf();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::string request = "RUN " + std::to_string(code.str().size()) + " " + std::to_string(input.str().size()) + " " + program_file + "\n"
+            + code.str() + input.str();
+        std::string header;
+        std::string body;
+        std::string status;
+        size_t body_size = 0;
+        double server_micros = 0;
+        if (!stream.write_all(request) || !stream.read_line(header)
+            || !(std::istringstream(header) >> status >> body_size >> server_micros) || !stream.read_exact(body, body_size)) {
+            std::cerr << "Error: Connection to " << socket_path << " lost" << std::endl;
+            close_handle(server);
+            return 1;
+        }
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        round_trips.push_back(micros);
+        server_times.push_back(server_micros);
+        if (status != "OK") ++failed;
+        std::cout << body;
+        std::cout << "=== " << program_file << ": " << micros << " us round trip, " << server_micros << " us on server ===\n";
+    }
+    close_handle(server);
+    print_latency_summary("Round trip", round_trips, std::cout);
+    print_latency_summary("On server", server_times, std::cout);
+    return failed == 0 ? 0 : 1;
+}
+
+int stop_server(const std::string& socket_path) {
+    socket_handle server = connect_to(socket_path);
+    if (server == INVALID_HANDLE) {
+        std::cerr << "Error: Cannot connect to " << socket_path << std::endl;
+        return 1;
+    }
+    SocketStream stream(server);
+    std::string header;
+    bool stopped = stream.write_all("SHUTDOWN\n") && stream.read_line(header);
+    close_handle(server);
+    return stopped ? 0 : 1;
+}
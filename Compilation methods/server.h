@@ -0,0 +1,27 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "driver.h"
+#include <string>
+
+// Сервер компиляции и выполнения на Unix domain socket. Таблицы лексера и парсера
+// строятся один раз при запуске. У каждого соединения свой поток ввода-вывода, а
+// каждый запрос выполняется в пуле из thread_count потоков, поэтому простаивающие
+// соединения не отнимают потоки у остальных. В одном соединении можно отправить
+// сколько угодно запросов; они выполняются по очереди.
+//
+// Протокол (заголовки — текстовые строки, тела передаются без изменений):
+//   запрос: RUN <длина программы> <длина ввода> <имя>\n<программа><ввод>
+//           SHUTDOWN\n
+//   ответ:  OK|ERROR <длина вывода> <время на сервере, мкс>\n<вывод>
+// Ввод — текст с целыми числами для read; вывод включает сообщения об ошибках.
+int run_server(const std::string& socket_path, size_t thread_count, const RunOptions& options);
+
+// Клиент: отправляет программы из list_file (формат как у --batch) по одному
+// соединению, печатает их вывод и задержки: по каждому запросу и перцентили.
+int run_client(const std::string& socket_path, const std::string& list_file);
+
+// Просит сервер завершиться после обработки открытых соединений.
+int stop_server(const std::string& socket_path);
+
+#endif // SERVER_H
@@ -0,0 +1,43 @@
+#include "source_lines.h"
+#include <algorithm>
+#include <cstring>
+
+SourceLines::SourceLines(std::string_view text, int first_line)
+    : text(text), first_line(first_line), cursor_offset(0), cursor_line(0), cursor_line_start(0) {}
+
+size_t SourceLines::find_line(size_t offset, size_t& line_start) const {
+    offset = std::min(offset, text.size());
+    if (line_starts.empty() && offset >= cursor_offset) {
+        std::string_view passed = text.substr(cursor_offset, offset - cursor_offset);
+        cursor_line += static_cast<size_t>(std::count(passed.begin(), passed.end(), '\n'));
+        size_t last_newline = passed.rfind('\n');
+        if (last_newline != std::string_view::npos) cursor_line_start = cursor_offset + last_newline + 1;
+        cursor_offset = offset;
+        line_start = cursor_line_start;
+        return cursor_line;
+    }
+    if (line_starts.empty()) {
+        line_starts.push_back(0);
+        const char* begin = text.data();
+        const char* end = begin + text.size();
+        for (const char* p = begin; p < end; ++p) {
+            p = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            if (!p) break;
+            line_starts.push_back(static_cast<size_t>(p - begin) + 1);
+        }
+    }
+    size_t index = static_cast<size_t>(std::upper_bound(line_starts.begin(), line_starts.end(), offset) - line_starts.begin()) - 1;
+    line_start = line_starts[index];
+    return index;
+}
+
+int SourceLines::line(size_t offset) const {
+    size_t line_start;
+    return first_line + static_cast<int>(find_line(offset, line_start));
+}
+
+int SourceLines::column(size_t offset) const {
+    size_t line_start;
+    find_line(offset, line_start);
+    return static_cast<int>(offset - line_start) + 1;
+}
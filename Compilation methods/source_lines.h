@@ -0,0 +1,34 @@
+#ifndef SOURCE_LINES_H
+#define SOURCE_LINES_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Строки и позиции по смещению в тексте: лексемы хранят только смещение первого
+// символа, строка и позиция вычисляются, когда они нужны (строки ОПС, ошибки,
+// подробный вывод). Парсер спрашивает о лексемах по порядку, поэтому запросы с
+// неубывающим смещением обслуживает курсор: он досчитывает переводы строк от
+// прошлого запроса, и весь разбор проходит текст один раз без выделения памяти.
+// Индекс начал строк (memchr и бинарный поиск) строится только при первом запросе
+// назад — обычно это сообщение об ошибке. Текст должен жить дольше объекта.
+class SourceLines {
+public:
+    explicit SourceLines(std::string_view text, int first_line = 1);
+    SourceLines(std::string&&, int = 1) = delete; // временная строка умерла бы раньше объекта
+    int line(size_t offset) const;
+    int column(size_t offset) const; // с 1, в байтах, как считал лексер
+
+private:
+    size_t find_line(size_t offset, size_t& line_start) const; // номер строки от 0
+
+    std::string_view text;
+    int first_line;
+    mutable size_t cursor_offset;
+    mutable size_t cursor_line;
+    mutable size_t cursor_line_start;
+    mutable std::vector<size_t> line_starts; // пуст, пока не понадобился запрос назад
+};
+
+#endif // SOURCE_LINES_H
@@ -0,0 +1,295 @@
+#include "stats.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#ifdef __APPLE__
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+#endif
+
+static const char* const COUNTER_NAMES[] = {
+    "tokens", "rules_applied", "semantic_actions", "ops_emitted",
+    "instructions_executed", "jumps_taken", "symtab_lookups",
+};
+static_assert(sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0]) == static_cast<size_t>(Counter::COUNT), "COUNTER_NAMES must cover every counter");
+
+static const char* const PHASE_NAMES[] = {
+    "read", "lex", "parse", "optimize", "lower", "execute",
+};
+static_assert(sizeof(PHASE_NAMES) / sizeof(PHASE_NAMES[0]) == static_cast<size_t>(Phase::COUNT), "PHASE_NAMES must cover every phase");
+
+static const char* const MEMORY_OWNER_NAMES[] = {
+    "other", "lexer", "parser", "symbol_table", "optimizer", "bytecode", "interpreter",
+};
+static_assert(sizeof(MEMORY_OWNER_NAMES) / sizeof(MEMORY_OWNER_NAMES[0]) == static_cast<size_t>(MemoryOwner::COUNT), "MEMORY_OWNER_NAMES must cover every owner");
+
+static const MemoryOwner PHASE_OWNERS[] = {
+    MemoryOwner::OTHER, MemoryOwner::LEXER, MemoryOwner::PARSER, MemoryOwner::OPTIMIZER, MemoryOwner::BYTECODE, MemoryOwner::INTERPRETER,
+};
+static_assert(sizeof(PHASE_OWNERS) / sizeof(PHASE_OWNERS[0]) == static_cast<size_t>(Phase::COUNT), "PHASE_OWNERS must cover every phase");
+
+const char* get_counter_name(Counter counter) {
+    return COUNTER_NAMES[static_cast<size_t>(counter)];
+}
+
+const char* get_phase_name(Phase phase) {
+    return PHASE_NAMES[static_cast<size_t>(phase)];
+}
+
+const char* get_memory_owner_name(MemoryOwner owner) {
+    return MEMORY_OWNER_NAMES[static_cast<size_t>(owner)];
+}
+
+static uint64_t read_peak_rss_kb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize / 1024;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<uint64_t>(usage.ru_maxrss) / 1024; // на macOS — байты
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#endif
+#endif
+}
+
+#ifndef DISABLE_STATS
+thread_local uint64_t stats_counters[static_cast<size_t>(Counter::COUNT)];
+thread_local uint64_t stats_allocations;
+static thread_local uint64_t stats_bytes;
+static thread_local int64_t live_bytes;       // может быть отрицательным: блок освобождён не тем потоком
+static thread_local int64_t peak_live_bytes;
+static thread_local MemoryOwner memory_owner;
+static thread_local MemoryOwnerStats owner_stats[static_cast<size_t>(MemoryOwner::COUNT)];
+static bool memory_tracking = false;
+
+static size_t allocation_size(void* p) {
+#if defined(_WIN32)
+    return _msize(p);
+#elif defined(__APPLE__)
+    return malloc_size(p);
+#else
+    return malloc_usable_size(p);
+#endif
+}
+
+// Подсчёт выделений памяти. Массивные формы new/delete по умолчанию вызывают эти.
+void* operator new(std::size_t size) {
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    ++stats_allocations;
+    MemoryOwnerStats& owner = owner_stats[static_cast<size_t>(memory_owner)];
+    ++owner.allocations;
+    if (memory_tracking) {
+        size_t bytes = allocation_size(p);
+        owner.bytes += bytes;
+        stats_bytes += bytes;
+        live_bytes += static_cast<int64_t>(bytes);
+        if (live_bytes > peak_live_bytes) peak_live_bytes = live_bytes;
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    if (p && memory_tracking) live_bytes -= static_cast<int64_t>(allocation_size(p));
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    operator delete(p);
+}
+
+bool stats_enabled_in_build() {
+    return true;
+}
+
+void set_memory_tracking(bool enabled) {
+    memory_tracking = enabled;
+}
+
+bool get_memory_tracking() {
+    return memory_tracking;
+}
+
+MemoryScope::MemoryScope(MemoryOwner owner) : previous(memory_owner) {
+    memory_owner = owner;
+}
+
+MemoryScope::~MemoryScope() {
+    memory_owner = previous;
+}
+
+static uint64_t current_allocations() {
+    return stats_allocations;
+}
+
+static uint64_t current_bytes() {
+    return stats_bytes;
+}
+
+// Начинает отсчёт пика занятой кучи и возвращает её текущий объём.
+static int64_t restart_peak_tracking() {
+    peak_live_bytes = live_bytes;
+    return live_bytes;
+}
+
+static uint64_t peak_bytes_since(int64_t start) {
+    return peak_live_bytes > start ? static_cast<uint64_t>(peak_live_bytes - start) : 0;
+}
+#else
+bool stats_enabled_in_build() {
+    return false;
+}
+
+void set_memory_tracking(bool) {}
+
+bool get_memory_tracking() {
+    return false;
+}
+
+MemoryScope::MemoryScope(MemoryOwner) : previous(MemoryOwner::OTHER) {}
+
+MemoryScope::~MemoryScope() {}
+
+static uint64_t current_allocations() {
+    return 0;
+}
+
+static uint64_t current_bytes() {
+    return 0;
+}
+
+static int64_t restart_peak_tracking() {
+    return 0;
+}
+
+static uint64_t peak_bytes_since(int64_t) {
+    return 0;
+}
+#endif
+
+void ProgramStats::begin(const std::string& name) {
+    program = name;
+#ifndef DISABLE_STATS
+    for (uint64_t& value : stats_counters) value = 0;
+    for (MemoryOwnerStats& owner : owner_stats) owner = MemoryOwnerStats();
+#endif
+}
+
+void ProgramStats::end() {
+#ifndef DISABLE_STATS
+    for (size_t i = 0; i < static_cast<size_t>(Counter::COUNT); ++i) {
+        counters[i] = stats_counters[i];
+    }
+    for (size_t i = 0; i < static_cast<size_t>(MemoryOwner::COUNT); ++i) {
+        owners[i] = owner_stats[i];
+    }
+#endif
+    peak_rss_kb = read_peak_rss_kb();
+}
+
+void ProgramStats::print(std::ostream& out) const {
+    out << "=== Statistics: " << program << " ===\n";
+    bool bytes = get_memory_tracking();
+    out << std::left << std::setw(12) << "phase" << std::right << std::setw(12) << "time, ms" << std::setw(14) << "allocations";
+    if (bytes) out << std::setw(14) << "bytes" << std::setw(14) << "peak bytes";
+    out << "\n";
+    for (size_t i = 0; i < static_cast<size_t>(Phase::COUNT); ++i) {
+        out << std::left << std::setw(12) << PHASE_NAMES[i] << std::right << std::fixed << std::setprecision(3)
+            << std::setw(12) << phases[i].seconds * 1000 << std::setw(14) << phases[i].allocations;
+        if (bytes) out << std::setw(14) << phases[i].bytes << std::setw(14) << phases[i].peak_bytes;
+        out << "\n";
+    }
+    out.unsetf(std::ios::fixed);
+    for (size_t i = 0; i < static_cast<size_t>(Counter::COUNT); ++i) {
+        out << COUNTER_NAMES[i] << ": " << counters[i] << "\n";
+    }
+    if (bytes) {
+        out << std::left << std::setw(14) << "owner" << std::right << std::setw(14) << "allocations" << std::setw(14) << "bytes" << "\n";
+        for (size_t i = 0; i < static_cast<size_t>(MemoryOwner::COUNT); ++i) {
+            out << std::left << std::setw(14) << MEMORY_OWNER_NAMES[i] << std::right << std::setw(14) << owners[i].allocations
+                << std::setw(14) << owners[i].bytes << "\n";
+        }
+        out << "peak RSS: " << peak_rss_kb << " KB\n";
+    }
+}
+
+static void write_json_string(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec << std::setfill(' ');
+        else out << c;
+    }
+    out << '"';
+}
+
+void ProgramStats::write_json(std::ostream& out) const {
+    out << "{\"program\": ";
+    write_json_string(out, program);
+    out << ", \"success\": " << (success ? "true" : "false") << ", \"phases\": {";
+    for (size_t i = 0; i < static_cast<size_t>(Phase::COUNT); ++i) {
+        out << (i ? ", " : "") << "\"" << PHASE_NAMES[i] << "\": {\"seconds\": " << phases[i].seconds
+            << ", \"allocations\": " << phases[i].allocations << ", \"bytes\": " << phases[i].bytes
+            << ", \"peak_bytes\": " << phases[i].peak_bytes << "}";
+    }
+    out << "}, \"counters\": {";
+    for (size_t i = 0; i < static_cast<size_t>(Counter::COUNT); ++i) {
+        out << (i ? ", " : "") << "\"" << COUNTER_NAMES[i] << "\": " << counters[i];
+    }
+    out << "}, \"memory\": {";
+    for (size_t i = 0; i < static_cast<size_t>(MemoryOwner::COUNT); ++i) {
+        out << (i ? ", " : "") << "\"" << MEMORY_OWNER_NAMES[i] << "\": {\"allocations\": " << owners[i].allocations
+            << ", \"bytes\": " << owners[i].bytes << "}";
+    }
+    out << "}, \"peak_rss_kb\": " << peak_rss_kb << "}";
+}
+
+PhaseTimer::PhaseTimer(ProgramStats* stats, Phase phase)
+    : stats(stats), phase(phase), start(std::chrono::steady_clock::now()), start_allocations(current_allocations()),
+      start_bytes(current_bytes()), start_live_bytes(restart_peak_tracking()), owner(PHASE_OWNERS[static_cast<size_t>(phase)]) {}
+
+PhaseTimer::~PhaseTimer() {
+    if (!stats) return;
+    PhaseStats& result = stats->phases[static_cast<size_t>(phase)];
+    result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.allocations += current_allocations() - start_allocations;
+    result.bytes += current_bytes() - start_bytes;
+    result.peak_bytes = std::max(result.peak_bytes, peak_bytes_since(start_live_bytes));
+}
+
+void StatsLog::add(const ProgramStats& stats) {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.push_back(stats);
+}
+
+bool StatsLog::write_json(const std::string& filename) const {
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    out << "[\n";
+    for (size_t i = 0; i < entries.size(); ++i) {
+        out << "  ";
+        entries[i].write_json(out);
+        out << (i + 1 < entries.size() ? ",\n" : "\n");
+    }
+    out << "]\n";
+    return static_cast<bool>(out);
+}
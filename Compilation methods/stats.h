@@ -0,0 +1,124 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Счётчики работы компилятора и интерпретатора. Увеличиваются в thread_local
+// массиве, поэтому не требуют синхронизации в пакетном режиме. При сборке с
+// DISABLE_STATS макросы ничего не делают, а operator new не подменяется.
+enum class Counter {
+    TOKENS,             // лексем выдано лексером
+    RULES_APPLIED,      // применено правил грамматики
+    SEMANTIC_ACTIONS,   // выполнено семантических действий
+    OPS_EMITTED,        // записано операций ОПС
+    INSTRUCTIONS,       // выполнено инструкций
+    JUMPS_TAKEN,        // выполнено переходов
+    SYMTAB_LOOKUPS,     // обращений к таблице символов
+    COUNT
+};
+
+enum class Phase {
+    READ, LEX, PARSE, OPTIMIZE, LOWER, EXECUTE,
+    COUNT
+};
+
+// Владелец выделений памяти. PhaseTimer назначает владельца по фазе, таблица символов
+// переназначает его на время своих методов (STATS_MEMORY_SCOPE).
+enum class MemoryOwner {
+    OTHER, LEXER, PARSER, SYMBOL_TABLE, OPTIMIZER, BYTECODE, INTERPRETER,
+    COUNT
+};
+
+const char* get_counter_name(Counter counter);
+const char* get_phase_name(Phase phase);
+const char* get_memory_owner_name(MemoryOwner owner);
+
+#ifndef DISABLE_STATS
+extern thread_local uint64_t stats_counters[static_cast<size_t>(Counter::COUNT)];
+extern thread_local uint64_t stats_allocations;
+#define STATS_ADD(counter, n) (stats_counters[static_cast<size_t>(Counter::counter)] += (n))
+#define STATS_INC(counter) STATS_ADD(counter, 1)
+#define STATS_MEMORY_SCOPE(owner) MemoryScope memory_scope(MemoryOwner::owner)
+#else
+#define STATS_ADD(counter, n) ((void)0)
+#define STATS_INC(counter) ((void)0)
+#define STATS_MEMORY_SCOPE(owner) ((void)0)
+#endif
+
+bool stats_enabled_in_build();
+
+// Учёт байтов (размер блока берётся у malloc) включается явно, до запуска потоков;
+// без него operator new только считает выделения.
+void set_memory_tracking(bool enabled);
+bool get_memory_tracking();
+
+// Назначает владельца выделений текущего потока до конца области видимости.
+class MemoryScope {
+public:
+    explicit MemoryScope(MemoryOwner owner);
+    ~MemoryScope();
+private:
+    MemoryOwner previous;
+};
+
+struct PhaseStats {
+    double seconds = 0;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;       // выделено байтов
+    uint64_t peak_bytes = 0;  // наибольший прирост занятой кучи от начала фазы
+};
+
+struct MemoryOwnerStats {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+struct ProgramStats {
+    std::string program;
+    bool success = false;
+    PhaseStats phases[static_cast<size_t>(Phase::COUNT)];
+    uint64_t counters[static_cast<size_t>(Counter::COUNT)] = {};
+    MemoryOwnerStats owners[static_cast<size_t>(MemoryOwner::COUNT)];
+    uint64_t peak_rss_kb = 0; // пиковый размер резидентной памяти процесса
+
+    // Начинает сбор: обнуляет счётчики текущего потока.
+    void begin(const std::string& name);
+    // Забирает значения счётчиков текущего потока.
+    void end();
+    void print(std::ostream& out) const;
+    void write_json(std::ostream& out) const;
+};
+
+// Замер одной фазы: время, число выделений и байтов от создания до разрушения.
+// Выделения внутри фазы приписываются её владельцу (лексер, парсер, ...), даже
+// с нулевым указателем. Фазы не должны быть вложенными: пик кучи отсчитывается заново.
+class PhaseTimer {
+public:
+    PhaseTimer(ProgramStats* stats, Phase phase);
+    ~PhaseTimer();
+private:
+    ProgramStats* stats;
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+    uint64_t start_allocations;
+    uint64_t start_bytes;
+    int64_t start_live_bytes;
+    MemoryScope owner;
+};
+
+// Статистика нескольких программ для --stats-json; add можно вызывать из разных потоков.
+class StatsLog {
+public:
+    void add(const ProgramStats& stats);
+    bool write_json(const std::string& filename) const;
+private:
+    mutable std::mutex mutex;
+    std::vector<ProgramStats> entries;
+};
+
+#endif // STATS_H
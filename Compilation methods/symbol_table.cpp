@@ -1,34 +1,41 @@
 #include "symbol_table.h"
+#include "stats.h"
 #include <stdexcept>
 #include <iostream>
 
-SymbolTable::SymbolTable() {}
+SymbolTable::SymbolTable() : silent_mode_active(false), out(&std::cout) {}
 
 void SymbolTable::add_variable(const std::string& name, int value) {
+    STATS_MEMORY_SCOPE(SYMBOL_TABLE);
+    STATS_INC(SYMTAB_LOOKUPS);
     if (variables.find(name) != variables.end() || arrays.find(name) != arrays.end()) {
         throw std::runtime_error("Variable or array '" + name + "' already exists");
     }
     variables[name] = value;
     if (!silent_mode_active) {
-        std::cout << "Added variable: " << name << " = " << value << "\n";
+        *out << "Added variable: " << name << " = " << value << "\n";
     }
 }
 
 void SymbolTable::add_array(const std::string& name, int size) {
+    STATS_MEMORY_SCOPE(SYMBOL_TABLE);
+    STATS_INC(SYMTAB_LOOKUPS);
     if (variables.find(name) != variables.end() || arrays.find(name) != arrays.end()) {
         throw std::runtime_error("Variable or array '" + name + "' already exists");
     }
     arrays[name] = std::vector<int>(size, 0);
     if (!silent_mode_active) {
-        std::cout << "Added array: " << name << " with size " << size << "\n";
+        *out << "Added array: " << name << " with size " << size << "\n";
     }
 }
 
 bool SymbolTable::exists(const std::string& name) const {
+    STATS_INC(SYMTAB_LOOKUPS);
     return variables.find(name) != variables.end() || arrays.find(name) != arrays.end();
 }
 
 int SymbolTable::get_variable(const std::string& name) const {
+    STATS_INC(SYMTAB_LOOKUPS);
     auto it = variables.find(name);
     if (it == variables.end()) {
         throw std::runtime_error("Variable '" + name + "' not found");
@@ -37,6 +44,7 @@ int SymbolTable::get_variable(const std::string& name) const {
 }
 
 void SymbolTable::set_variable(const std::string& name, int value) {
+    STATS_INC(SYMTAB_LOOKUPS);
     auto it = variables.find(name);
     if (it == variables.end()) {
         throw std::runtime_error("Variable '" + name + "' not found");
@@ -45,6 +53,7 @@ void SymbolTable::set_variable(const std::string& name, int value) {
 }
 
 std::vector<int>& SymbolTable::get_array(const std::string& name) {
+    STATS_INC(SYMTAB_LOOKUPS);
     auto it = arrays.find(name);
     if (it == arrays.end()) {
         throw std::runtime_error("Array '" + name + "' not found");
@@ -52,7 +61,15 @@ std::vector<int>& SymbolTable::get_array(const std::string& name) {
     return it->second;
 }
 
+// Создаёт или заменяет массив без сообщений (интерпретатор байткода возвращает состояние в таблицу).
+void SymbolTable::set_array(const std::string& name, const std::vector<int>& values) {
+    STATS_MEMORY_SCOPE(SYMBOL_TABLE);
+    STATS_INC(SYMTAB_LOOKUPS);
+    arrays[name] = values;
+}
+
 void SymbolTable::set_array_element(const std::string& name, int index, int value) {
+    STATS_INC(SYMTAB_LOOKUPS);
     auto it = arrays.find(name);
     if (it == arrays.end()) {
         throw std::runtime_error("Array '" + name + "' not found");
@@ -74,19 +91,20 @@ void SymbolTable::clear() {
 
 void SymbolTable::print() const {
     for (const auto& var : variables) {
-        std::cout << "Variable: " << var.first << ", Value: " << var.second << "\n";
+        *out << "Variable: " << var.first << ", Value: " << var.second << "\n";
     }
     for (const auto& arr : arrays) {
-        std::cout << "Array: " << arr.first << ", Size: " << arr.second.size() << ", Values: [";
+        *out << "Array: " << arr.first << ", Size: " << arr.second.size() << ", Values: [";
         for (size_t i = 0; i < arr.second.size(); ++i) {
-            std::cout << arr.second[i];
-            if (i < arr.second.size() - 1) std::cout << ", ";
+            *out << arr.second[i];
+            if (i < arr.second.size() - 1) *out << ", ";
         }
-        std::cout << "]\n";
+        *out << "]\n";
     }
 }
 
 std::vector<int>* SymbolTable::get_array_maybe(const std::string& name) {
+    STATS_INC(SYMTAB_LOOKUPS);
     auto it = arrays.find(name);
     if (it == arrays.end()) {
         return nullptr;
@@ -95,6 +113,7 @@ std::vector<int>* SymbolTable::get_array_maybe(const std::string& name) {
 }
 
 const std::vector<int>* SymbolTable::get_array_maybe(const std::string& name) const {
+    STATS_INC(SYMTAB_LOOKUPS);
     auto it = arrays.find(name);
     if (it == arrays.end()) {
         return nullptr;
@@ -104,4 +123,8 @@ const std::vector<int>* SymbolTable::get_array_maybe(const std::string& name) co
 
 void SymbolTable::set_silent_mode(bool mode) {
     silent_mode_active = mode;
+}
+
+void SymbolTable::set_output_stream(std::ostream& stream) {
+    out = &stream;
 }
\ No newline at end of file
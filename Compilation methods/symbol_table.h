@@ -5,6 +5,7 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <ostream>
 
 class SymbolTable {
 public:
@@ -15,6 +16,7 @@ public:
     int get_variable(const std::string& name) const;
     void set_variable(const std::string& name, int value);
     std::vector<int>& get_array(const std::string& name);
+    void set_array(const std::string& name, const std::vector<int>& values);
     void set_array_element(const std::string& name, int index, int value);
     const std::map<std::string, int>& get_variables() const;
     void clear();
@@ -22,11 +24,13 @@ public:
     std::vector<int>* get_array_maybe(const std::string& name);
     const std::vector<int>* get_array_maybe(const std::string& name) const;
     void set_silent_mode(bool mode);
+    void set_output_stream(std::ostream& stream);
 private:
     std::map<std::string, int> variables;
     std::map<std::string, std::vector<int>> arrays;
 
     bool silent_mode_active;
+    std::ostream* out;
 };
 
 #endif // SYMBOL_TABLE_H
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "thread_pool.h"
+
+// Номер рабочего потока текущего пула, чтобы задачи, порождённые внутри задачи,
+// попадали в собственную очередь потока.
+static thread_local const ThreadPool* current_pool = nullptr;
+static thread_local size_t current_worker = 0;
+
+ThreadPool::ThreadPool(size_t thread_count) : queued(0), pending(0), next_queue(0), stopping(false) {
+    if (thread_count == 0) thread_count = 1;
+    for (size_t i = 0; i < thread_count; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait_idle();
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        stopping = true;
+    }
+    work_available.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t target;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        target = (current_pool == this) ? current_worker : (next_queue++ % queues.size());
+        ++queued;
+        ++pending;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    work_available.notify_one();
+}
+
+void ThreadPool::wait_idle() {
+    std::unique_lock<std::mutex> lock(state_mutex);
+    all_done.wait(lock, [this] { return pending == 0; });
+}
+
+bool ThreadPool::try_pop(size_t index, std::function<void()>& task) {
+    {
+        WorkerQueue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t k = 1; k < queues.size(); ++k) {
+        WorkerQueue& victim = *queues[(index + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::worker_loop(size_t index) {
+    current_pool = this;
+    current_worker = index;
+    while (true) {
+        std::function<void()> task;
+        if (try_pop(index, task)) {
+            {
+                std::lock_guard<std::mutex> lock(state_mutex);
+                --queued;
+            }
+            task();
+            std::lock_guard<std::mutex> lock(state_mutex);
+            if (--pending == 0) {
+                all_done.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(state_mutex);
+        work_available.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) {
+            return;
+        }
+    }
+}
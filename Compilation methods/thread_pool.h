@@ -0,0 +1,42 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков с собственной очередью у каждого рабочего потока: поток берёт задачи
+// с конца своей очереди, а когда она пуста — крадёт с начала чужих.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t thread_count);
+    ~ThreadPool();
+    void submit(std::function<void()> task);
+    void wait_idle();
+    size_t size() const;
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void worker_loop(size_t index);
+    bool try_pop(size_t index, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex state_mutex;
+    std::condition_variable work_available;
+    std::condition_variable all_done;
+    size_t queued;   // задачи в очередях
+    size_t pending;  // поставленные и ещё не завершённые задачи
+    size_t next_queue;
+    bool stopping;
+};
+
+#endif // THREAD_POOL_H
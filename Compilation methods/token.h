@@ -1,15 +1,16 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include <cstdint>
 #include <string>
 
 struct Token {
     std::string type;  // KEYWORD, ID, NUMBER, SYMBOL, EOF
     std::string value; // Значение токена (например, "int", "a", "42", "+")
-    int line;          // Номер строки
-    int pos;           // Позиция в строке
-    Token(const std::string& t, const std::string& v, int l, int p)
-        : type(t), value(v), line(l), pos(p) {}
+    uint32_t offset;   // Смещение первого символа в тексте; строка и позиция — SourceLines
+    int name_id;       // для ID — номер имени в таблице имён лексера (Lexer::get_names), иначе -1
+    Token(const std::string& t, const std::string& v, uint32_t o, int name = -1)
+        : type(t), value(v), offset(o), name_id(name) {}
 };
 
 #endif
\ No newline at end of file